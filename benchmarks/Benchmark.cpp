@@ -0,0 +1,469 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/* Benchmark
+
+Windowless microbenchmarks of the simulation and rendering pipeline.
+
+Measures `Cellular::doUpdate` for every combination of rule, geometry,
+grid size, thread count and update mode (in-place updates are skipped
+for geometries which don't support them), as well as `Model::updatePixels` (which
+colorizes the cells on the worker threads) for every rule and grid
+size. The results are
+written as JSON to stdout or to the file specified by `--output`. Run
+with `--help` for a list of options.
+
+Every benchmark first runs a number of warm-up iterations, then
+repeats the measured call until both the minimum number of
+repetitions and the minimum measurement time are reached. The random
+populations are generated from a fixed seed, so that consecutive runs
+measure the same workload.
+
+The number and size of the heap allocations made by the measured
+iterations are reported as well, and so is the number of bytes of the
+space residing on each NUMA node (if known). Pass `--pin` to pin the
+simulation threads to the CPUs, ordered by NUMA node, and `--arena` to
+allocate the spaces from an `Arena` backed by huge pages.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <thread>
+
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "detail/CountAllocations.h"
+#include "geometry/Border.h"
+#include "geometry/Projective.h"
+#include "geometry/Torus.h"
+#include "geometry/WrapX.h"
+#include "geometry/WrapY.h"
+#include "rules/Brain.h"
+#include "rules/Cyclic.h"
+#include "rules/GameOfLife.h"
+#include "rules/SRLoop.h"
+#include "Arena.h"
+#include "Cellular.h"
+#include "Model.h"
+
+using namespace drautomaton;
+
+namespace {
+
+/* Traits
+
+Rule-specific data required to set up a benchmark: The rule's name, the
+number of its states and the conversion of an integer in
+`[0, states)` to a state.
+*/
+
+template<typename Rule>
+struct Traits;
+
+template<>
+struct Traits<GameOfLife>
+{
+  static std::string name() { return "GameOfLife"; }
+  static constexpr int states = 2;
+  static GameOfLife::State state(int i) { return static_cast<GameOfLife::State>(i); }
+};
+
+template<>
+struct Traits<Brain>
+{
+  static std::string name() { return "Brain"; }
+  static constexpr int states = 3;
+  static Brain::State state(int i) { return static_cast<Brain::State>(i); }
+};
+
+template<int N>
+struct Traits<Cyclic<N>>
+{
+  static std::string name() { return "Cyclic<" + std::to_string(N) + ">"; }
+  static constexpr int states = N;
+  static CyclicState<N> state(int i) { CyclicState<N> s; s.value = i; return s; }
+};
+
+template<>
+struct Traits<SRLoop>
+{
+  static std::string name() { return "SRLoop"; }
+  static constexpr int states = 8;
+  static SRLoop::State state(int i) { return static_cast<SRLoop::State>(i); }
+};
+
+const std::vector<std::string> geometries = {
+  "Torus", "Projective", "Border", "WrapX", "WrapY"
+};
+
+struct Config
+{
+  std::vector<int> sizes{};
+  std::vector<int> threads{};
+  int warmup = 2;
+  int min_repetitions = 5;
+  double min_time = 0.2;  // Seconds.
+  unsigned int seed = 0;
+  QString filter{};
+  bool pin = false;  // Pin the workers of `Cellular`.
+  bool arena = false;  // Allocate the spaces of `Cellular` from an `Arena`.
+};
+
+template<typename Rule>
+std::shared_ptr<AbstractGeometry<typename Rule::State>>
+makeGeometry(const std::string& name)
+{
+  using State = typename Rule::State;
+  if (name == "Torus")
+  {
+    return std::make_shared<geometry::Torus<State>>();
+  }
+  else if (name == "Projective")
+  {
+    return std::make_shared<geometry::Projective<State>>();
+  }
+  else if (name == "Border")
+  {
+    auto geometry = std::make_shared<geometry::Border<State>>();
+    geometry->setDefault(Traits<Rule>::state(0));
+    return geometry;
+  }
+  else if (name == "WrapX")
+  {
+    auto geometry = std::make_shared<geometry::WrapX<State>>();
+    geometry->setDefault(Traits<Rule>::state(0));
+    return geometry;
+  }
+  else if (name == "WrapY")
+  {
+    auto geometry = std::make_shared<geometry::WrapY<State>>();
+    geometry->setDefault(Traits<Rule>::state(0));
+    return geometry;
+  }
+  throw std::runtime_error{"Unknown geometry: " + name};
+}
+
+template<typename Rule>
+void
+populate(Space<typename Rule::State>& space, unsigned int seed)
+{
+  std::mt19937 gen{seed};
+  std::uniform_int_distribution<> dis(0, Traits<Rule>::states - 1);
+  for (int x = 0; x < space.width(); ++x)
+  {
+    for (int y = 0; y < space.height(); ++y)
+    {
+      space.cell(x, y) = Traits<Rule>::state(dis(gen));
+    }
+  }
+}
+
+struct Samples
+{
+  std::vector<double> ns{};  // Duration of each run.
+  drprof::Allocations allocations{};  // Total of all runs.
+};
+
+// Run `f` until the minimum number of repetitions and the minimum
+// measurement time are reached.
+Samples
+measure(const Config& config, const std::function<void()>& f)
+{
+  for (int i = 0; i < config.warmup; ++i)
+  {
+    f();
+  }
+
+  Samples result{};
+  double total = 0.0;
+  while (static_cast<int>(result.ns.size()) < config.min_repetitions
+         or total < config.min_time * 1e9)
+  {
+    auto before = drprof::allocations();
+    auto t0 = std::chrono::steady_clock::now();
+    f();
+    auto t1 = std::chrono::steady_clock::now();
+    auto after = drprof::allocations();
+    double ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    result.ns.push_back(ns);
+    result.allocations.count += after.count - before.count;
+    result.allocations.bytes += after.bytes - before.bytes;
+    total += ns;
+  }
+  return result;
+}
+
+QJsonObject
+summarize(const Samples& measurement, double cells)
+{
+  auto samples = measurement.ns;
+  std::sort(samples.begin(), samples.end());
+  auto n = samples.size();
+  double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+  double var = 0.0;
+  for (auto s : samples)
+  {
+    var += (s - mean) * (s - mean);
+  }
+  double median = (n % 2) ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+
+  QJsonObject result;
+  result["repetitions"] = static_cast<int>(n);
+  result["min_ns"] = samples.front();
+  result["max_ns"] = samples.back();
+  result["median_ns"] = median;
+  result["mean_ns"] = mean;
+  result["stddev_ns"] = std::sqrt(var / n);
+  result["cells_per_second"] = cells / (median * 1e-9);
+  result["allocations_per_iteration"] = static_cast<double>(measurement.allocations.count) / n;
+  result["allocated_bytes_per_iteration"] = static_cast<double>(measurement.allocations.bytes) / n;
+  return result;
+}
+
+bool
+selected(const Config& config, const QString& name)
+{
+  return config.filter.isEmpty() or name.contains(config.filter);
+}
+
+template<typename Rule>
+void
+benchCellular(const Config& config, QJsonArray& out)
+{
+  for (const auto& geometry : geometries)
+  {
+    for (auto size : config.sizes)
+    {
+      for (auto threads : config.threads)
+      {
+        for (auto mode : {UpdateMode::buffered, UpdateMode::inPlace})
+        {
+          bool in_place = mode == UpdateMode::inPlace;
+          auto name = QString::fromStdString(
+              "Cellular::doUpdate/" + Traits<Rule>::name() + "/" + geometry
+              + "/" + std::to_string(size) + "x" + std::to_string(size)
+              + "/threads:" + std::to_string(threads)
+              + (in_place ? "/in-place" : "")
+            );
+          auto instance = makeGeometry<Rule>(geometry);
+          if (not selected(config, name) or (in_place and not instance->preservesColumns()))
+          {
+            continue;
+          }
+          std::cerr << name.toStdString() << std::endl;
+
+          Arena arena{};
+          auto resource = config.arena ? &arena : std::pmr::get_default_resource();
+          Cellular<Rule> cellular{size, size, static_cast<std::size_t>(threads), mode, resource};
+          cellular.setGeometry(instance);
+          populate<Rule>(cellular.space(), config.seed);
+          bool pinned = config.pin and cellular.pinThreads();
+
+          auto result = summarize(
+              measure(config, [&] () { cellular.doUpdate(); }),
+              static_cast<double>(size) * size
+            );
+          result["name"] = name;
+          result["benchmark"] = "Cellular::doUpdate";
+          result["rule"] = QString::fromStdString(Traits<Rule>::name());
+          result["geometry"] = QString::fromStdString(geometry);
+          result["width"] = size;
+          result["height"] = size;
+          result["threads"] = threads;
+          result["mode"] = in_place ? "in-place" : "buffered";
+          result["pinned"] = pinned;
+          result["arena"] = config.arena;
+          QJsonArray memory{};
+          for (auto bytes : cellular.memoryPerNode())
+          {
+            memory.append(static_cast<double>(bytes));
+          }
+          result["memory_per_node"] = memory;
+          out.append(result);
+        }
+      }
+    }
+  }
+}
+
+template<typename Rule>
+void
+benchModel(const Config& config, QJsonArray& out)
+{
+  for (auto size : config.sizes)
+  {
+    auto name = QString::fromStdString(
+        "Model::updatePixels/" + Traits<Rule>::name() + "/"
+        + std::to_string(size) + "x" + std::to_string(size)
+      );
+    if (not selected(config, name))
+    {
+      continue;
+    }
+    std::cerr << name.toStdString() << std::endl;
+
+    auto cellular = std::make_shared<Cellular<Rule>>(size, size);
+    populate<Rule>(cellular->space(), config.seed);
+    Model<Rule> model{cellular};
+    Palette palette{};
+    for (int i = 0; i < Traits<Rule>::states; ++i)
+    {
+      palette.setColor(i, qRgb((37 * i) % 256, (91 * i) % 256, (173 * i) % 256));
+    }
+    model.setPalette(palette);
+
+    // `onCellularUpdated` is a thin wrapper around `updatePixels`. No
+    // generation has been computed, so every tile is reported as
+    // changed, which is the worst case.
+    auto result = summarize(
+        measure(config, [&] () { model.onCellularUpdated(); }),
+        static_cast<double>(size) * size
+      );
+    result["name"] = name;
+    result["benchmark"] = "Model::updatePixels";
+    result["rule"] = QString::fromStdString(Traits<Rule>::name());
+    result["width"] = size;
+    result["height"] = size;
+    out.append(result);
+  }
+}
+
+template<typename Rule>
+void
+benchRule(const Config& config, QJsonArray& out)
+{
+  benchCellular<Rule>(config, out);
+  benchModel<Rule>(config, out);
+}
+
+std::vector<int>
+parseList(const QString& list)
+{
+  std::vector<int> result{};
+  for (const auto& item : list.split(',', Qt::SkipEmptyParts))
+  {
+    bool ok = false;
+    int value = item.toInt(&ok);
+    if (not ok or value < 1)
+    {
+      throw std::runtime_error{"Invalid list entry: " + item.toStdString()};
+    }
+    result.push_back(value);
+  }
+  return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  // Run without a window system.
+  qputenv("QT_QPA_PLATFORM", "offscreen");
+  QGuiApplication app{argc, argv};
+
+  auto hardware_concurrency = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("DrAutomaton microbenchmarks");
+  parser.addHelpOption();
+  QCommandLineOption sizes_option{"sizes", "Comma-separated grid sizes.", "list", "64,256,1024"};
+  QCommandLineOption threads_option{
+      "threads", "Comma-separated thread counts.", "list",
+      QString{"1,2,4,%1"}.arg(hardware_concurrency)
+    };
+  QCommandLineOption warmup_option{"warmup", "Number of warm-up iterations.", "n", "2"};
+  QCommandLineOption repetitions_option{"repetitions", "Minimum number of repetitions.", "n", "5"};
+  QCommandLineOption time_option{"min-time", "Minimum measurement time in seconds.", "s", "0.2"};
+  QCommandLineOption seed_option{"seed", "Seed for the random populations.", "n", "0"};
+  QCommandLineOption filter_option{"filter", "Only run benchmarks whose name contains this string.", "string"};
+  QCommandLineOption output_option{"output", "Write JSON to file instead of stdout.", "file"};
+  QCommandLineOption pin_option{"pin", "Pin the simulation threads to the CPUs, ordered by NUMA node."};
+  QCommandLineOption arena_option{"arena", "Allocate the spaces from a huge-page arena."};
+  parser.addOptions({
+      sizes_option, threads_option, warmup_option, repetitions_option,
+      time_option, seed_option, filter_option, output_option, pin_option,
+      arena_option
+    });
+  parser.process(app);
+
+  Config config{};
+  config.sizes = parseList(parser.value(sizes_option));
+  config.threads = parseList(parser.value(threads_option));
+  config.warmup = parser.value(warmup_option).toInt();
+  config.min_repetitions = std::max(1, parser.value(repetitions_option).toInt());
+  config.min_time = parser.value(time_option).toDouble();
+  config.seed = parser.value(seed_option).toUInt();
+  config.filter = parser.value(filter_option);
+  config.pin = parser.isSet(pin_option);
+  config.arena = parser.isSet(arena_option);
+
+  // Remove duplicates (the default thread list may contain the number
+  // of hardware threads twice).
+  std::sort(config.threads.begin(), config.threads.end());
+  config.threads.erase(std::unique(config.threads.begin(), config.threads.end()), config.threads.end());
+
+  QJsonArray benchmarks{};
+  benchRule<GameOfLife>(config, benchmarks);
+  benchRule<Brain>(config, benchmarks);
+  benchRule<Cyclic<16>>(config, benchmarks);
+  benchRule<SRLoop>(config, benchmarks);
+
+  QJsonObject context{};
+  context["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+  context["version"] = QString{DRAUTOMATON_VERSION};
+  context["hardware_concurrency"] = hardware_concurrency;
+  context["warmup"] = config.warmup;
+  context["min_repetitions"] = config.min_repetitions;
+  context["min_time"] = config.min_time;
+  context["seed"] = static_cast<int>(config.seed);
+  context["pin"] = config.pin;
+  context["arena"] = config.arena;
+
+  QJsonObject root{};
+  root["context"] = context;
+  root["benchmarks"] = benchmarks;
+  auto json = QJsonDocument{root}.toJson();
+
+  if (parser.isSet(output_option))
+  {
+    QFile file{parser.value(output_option)};
+    if (not file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+      std::cerr << "Failed to open " << file.fileName().toStdString() << std::endl;
+      return 1;
+    }
+    file.write(json);
+  }
+  else
+  {
+    std::cout << json.toStdString();
+  }
+
+  return 0;
+}
@@ -53,7 +53,7 @@ Item
     }
     onPositionChanged:
     {
-      view.onClicked(mouse.x, mouse.y)
+      view.onDragged(mouse.x, mouse.y)
       mouse.accepted = true
     }
   }
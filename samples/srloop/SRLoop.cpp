@@ -68,6 +68,10 @@ int main(int argc, char** argv)
   auto model = std::make_shared<Model<SRLoop>>(std::move(cellular));
   model->setViewport(45, 45, 110, 110);
 
+  // Compute the generations on a separate thread, so that the UI stays
+  // responsive.
+  model->setThreaded(true);
+
   /* **********************************
    * Configure QQuickView
    * ********************************** */
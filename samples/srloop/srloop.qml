@@ -37,6 +37,7 @@ Item
       case Qt.Key_4: { view.setFramerate(60); break; }
       case Qt.Key_Space: { view.toggle(); break; }
       case Qt.Key_Return: { view.showNextGeneration(); break; }
+      case Qt.Key_M: { view.maxSpeed = !view.maxSpeed; break; }
     }
   }
 
@@ -53,7 +54,7 @@ Item
     }
     onPositionChanged:
     {
-      view.onClicked(mouse.x, mouse.y)
+      view.onDragged(mouse.x, mouse.y)
       mouse.accepted = true
     }
   }
@@ -66,4 +67,15 @@ Item
     anchors.fill: parent
     anchors.margins: 0
   }
+
+  // Generation rate.
+  Text
+  {
+    anchors.left: parent.left
+    anchors.top: parent.top
+    anchors.margins: 8
+    color: "white"
+    text: view.generationsPerSecond.toFixed(1) + " / "
+        + view.targetGenerationsPerSecond.toFixed(1) + " gen/s"
+  }
 }
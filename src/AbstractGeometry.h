@@ -19,10 +19,15 @@
 #ifndef DRAUTOMATON_SRC_ABSTRACTGEOMETRY_H
 #define DRAUTOMATON_SRC_ABSTRACTGEOMETRY_H
 
+#include <memory_resource>
 #include <vector>
 
 namespace drautomaton {
 
+// Column of a `Space`, see there.
+template<typename T>
+using Column = std::pmr::vector<T>;
+
 /* AbstractGeometry
  
 Abstract interface for plane geometries obtained by glueing a rectangle along its sides. Every geometry (torus, projective plane, etc.) requires a seperate implementation of this interface.
@@ -44,8 +49,14 @@ public:
       int y,
       int width,
       int height,
-      const std::vector<std::vector<T>>& data
+      const std::vector<Column<T>>& data
     ) const = 0;
+
+  // Return `true` if the representative of every `(x, y)` lies in the
+  // column `x` modulo `width` (or is not part of the rectangle at all),
+  // so that the neighbors of a cell lie in the adjacent columns. The
+  // default is `false`.
+  virtual bool preservesColumns() const { return false; }
 };
 
 } // namespace drautomaton
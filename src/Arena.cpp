@@ -0,0 +1,234 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Arena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace drautomaton {
+
+namespace {
+
+std::size_t
+roundUp(std::size_t size, std::size_t multiple)
+{
+  return (size + multiple - 1) / multiple * multiple;
+}
+
+} // namespace
+
+Arena::Arena(Pages pages)
+:
+  pages_{pages}
+{}
+
+Arena::~Arena()
+{
+  for (const auto& chunk : chunks_)
+  {
+    unmap(chunk);
+  }
+  for (const auto& p : large_)
+  {
+    unmap(p.second);
+  }
+}
+
+Arena::Pages
+Arena::pages() const
+{
+  return pages_;
+}
+
+std::size_t
+Arena::capacity() const
+{
+  std::lock_guard<std::mutex> lock{mutex_};
+  return normal_capacity_ + reserved_capacity_;
+}
+
+std::size_t
+Arena::reservedCapacity() const
+{
+  std::lock_guard<std::mutex> lock{mutex_};
+  return reserved_capacity_;
+}
+
+void
+Arena::beginPlacement()
+{
+  std::lock_guard<std::mutex> lock{mutex_};
+  ++placements_;
+}
+
+void
+Arena::endPlacement()
+{
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (--placements_ == 0)
+  {
+    // The rest of the chunks of the placing threads is lost.
+    placing_.clear();
+  }
+}
+
+void*
+Arena::do_allocate(std::size_t bytes, std::size_t align)
+{
+  bytes = roundUp(std::max<std::size_t>(bytes, 1), alignment);
+  if (bytes >= huge_page_size / 2 or align > alignment)
+  {
+    auto chunk = map(roundUp(bytes, huge_page_size));
+    std::lock_guard<std::mutex> lock{mutex_};
+    large_.emplace(chunk.data, chunk);
+    count(chunk, true);
+    return chunk.data;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto& list = free_[bytes];
+  if (placements_ == 0 and not list.empty())
+  {
+    auto ptr = list.back();
+    list.pop_back();
+    return ptr;
+  }
+  auto& cursor = placements_ > 0 ? placing_[std::this_thread::get_id()] : cursor_;
+  if (static_cast<std::size_t>(cursor.end - cursor.current) < bytes)
+  {
+    // The rest of the current chunk is lost.
+    auto chunk = map(huge_page_size);
+    chunks_.push_back(chunk);
+    count(chunk, true);
+    cursor.current = static_cast<char*>(chunk.data);
+    cursor.end = cursor.current + chunk.size;
+  }
+  auto ptr = cursor.current;
+  cursor.current += bytes;
+  return ptr;
+}
+
+void
+Arena::do_deallocate(void* ptr, std::size_t bytes, std::size_t align)
+{
+  bytes = roundUp(std::max<std::size_t>(bytes, 1), alignment);
+  if (bytes >= huge_page_size / 2 or align > alignment)
+  {
+    Chunk chunk{};
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      auto it = large_.find(ptr);
+      chunk = it->second;
+      large_.erase(it);
+      count(chunk, false);
+    }
+    unmap(chunk);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  free_[bytes].push_back(ptr);
+}
+
+void
+Arena::count(const Chunk& chunk, bool add)
+{
+  auto& capacity = chunk.reserved ? reserved_capacity_ : normal_capacity_;
+  capacity = add ? capacity + chunk.size : capacity - chunk.size;
+}
+
+bool
+Arena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+  return this == &other;
+}
+
+#ifdef __linux__
+
+Arena::Chunk
+Arena::map(std::size_t size)
+{
+  if (pages_ == Pages::reserved)
+  {
+    auto data = mmap(
+        nullptr, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0
+      );
+    if (data != MAP_FAILED)
+    {
+      return {data, size, true};
+    }
+  }
+
+  // Map an extra huge page to align the chunk, then trim the excess.
+  auto data = mmap(
+      nullptr, size + huge_page_size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+    );
+  if (data == MAP_FAILED)
+  {
+    throw std::bad_alloc{};
+  }
+  auto begin = reinterpret_cast<std::uintptr_t>(data);
+  auto aligned = roundUp(begin, huge_page_size);
+  if (aligned != begin)
+  {
+    munmap(data, aligned - begin);
+  }
+  if (auto tail = begin + huge_page_size - aligned)
+  {
+    munmap(reinterpret_cast<void*>(aligned + size), tail);
+  }
+  if (pages_ != Pages::normal)
+  {
+    // Errors are ignored, the chunk is usable anyway.
+    madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+  }
+
+  return {reinterpret_cast<void*>(aligned), size, false};
+}
+
+void
+Arena::unmap(const Chunk& chunk)
+{
+  munmap(chunk.data, chunk.size);
+}
+
+#else
+
+Arena::Chunk
+Arena::map(std::size_t size)
+{
+  return {::operator new(size, std::align_val_t{huge_page_size}), size, false};
+}
+
+void
+Arena::unmap(const Chunk& chunk)
+{
+  ::operator delete(chunk.data, std::align_val_t{huge_page_size});
+}
+
+#endif
+
+} // namespace drautomaton
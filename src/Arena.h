@@ -0,0 +1,155 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_ARENA_H
+#define DRAUTOMATON_SRC_ARENA_H
+
+#include <cstddef>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace drautomaton {
+
+/* Arena
+
+Memory resource for the columns of a `Space` and the buffers of
+`Cellular`. Every block is aligned to (at least) `alignment`, the size
+of a cache line, so that columns are suitable for aligned vector loads.
+Memory is obtained from the system in chunks of `huge_page_size`, which
+are backed by huge pages if possible to reduce the number of TLB misses:
+
+- `Pages::transparent`: The kernel is advised to back the chunks by
+  transparent huge pages (`madvise(MADV_HUGEPAGE)`).
+
+- `Pages::reserved`: The chunks are mapped from the pool of huge pages
+  reserved by the administrator (see `/proc/sys/vm/nr_hugepages`). If
+  the pool is exhausted, `transparent` is used instead.
+
+- `Pages::normal`: Regular pages.
+
+On platforms other than Linux, chunks are allocated using the aligned
+`operator new`, and `pages` is ignored. All methods are thread-safe.
+The arena must outlive all memory allocated from it.
+
+On NUMA hosts, a page resides on the node of the thread which first
+touches it, so a recycled block stays where it was first used. Between
+`beginPlacement` and `endPlacement`, allocations are therefore served
+from memory that no thread has touched yet, never from recycled blocks,
+and every thread allocates from chunks of its own. Thus, a thread which
+first-touches the memory it allocates places all of it on its node,
+even if the chunks are backed by huge pages. `Cellular` uses this to
+place each block on its worker's node.
+
+*** Implementation details ***
+
+* Blocks of at least half a chunk (or with an alignment stricter than
+  `alignment`) get chunks of their own, which are returned to the
+  system on deallocation.
+
+* Smaller blocks are carved from the current chunk. Deallocated blocks
+  are kept in `free_` (by size) for reuse, as a space consists of many
+  columns of the same size. These chunks are returned to the system by
+  the dtor only.
+
+* Chunks are aligned to `huge_page_size`, which is required for
+  transparent huge pages.
+
+* During a placement, every thread carves its blocks from its own entry
+  of `placing_`. The rest of these chunks is abandoned when the last
+  placement ends, so a placement wastes less than one chunk per thread.
+*/
+
+class Arena : public std::pmr::memory_resource
+{
+public:
+  enum class Pages
+  {
+    normal,
+    transparent,
+    reserved
+  };
+
+  static constexpr std::size_t alignment = 64;
+  static constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+  explicit Arena(Pages pages = Pages::transparent);
+  ~Arena() override;
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  Pages pages() const;
+
+  // Return the number of bytes obtained from the system, and the number
+  // of those which were mapped from the reserved pool of huge pages.
+  std::size_t capacity() const;
+  std::size_t reservedCapacity() const;
+
+  // Until the matching call of `endPlacement`, don't recycle deallocated
+  // blocks, and serve every thread from chunks of its own. Calls may be
+  // nested.
+  void beginPlacement();
+  void endPlacement();
+
+protected:
+  void* do_allocate(std::size_t bytes, std::size_t align) override;
+  void do_deallocate(void* ptr, std::size_t bytes, std::size_t align) override;
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+private:
+  // Free part of a chunk.
+  struct Cursor
+  {
+    char* current = nullptr;
+    char* end = nullptr;
+  };
+
+  struct Chunk
+  {
+    void* data;
+    std::size_t size;
+    bool reserved;  // Mapped from the reserved pool.
+  };
+
+  // Obtain/return a chunk of `size` bytes (a multiple of
+  // `huge_page_size`) from/to the system.
+  Chunk map(std::size_t size);
+  void unmap(const Chunk&);
+
+  // Add `chunk` to the capacity, or subtract it. Requires `mutex_`.
+  void count(const Chunk& chunk, bool add);
+
+  Pages pages_;
+  mutable std::mutex mutex_{};  // Guards the members below.
+  std::size_t normal_capacity_ = 0;  // Not from the reserved pool.
+  std::size_t reserved_capacity_ = 0;
+  std::vector<Chunk> chunks_{};  // Shared chunks.
+  Cursor cursor_{};  // Current shared chunk.
+  std::unordered_map<std::thread::id, Cursor> placing_{};  // Chunks of placing threads.
+  std::map<std::size_t, std::vector<void*>> free_{};
+  std::unordered_map<void*, Chunk> large_{};  // Own chunks.
+  int placements_ = 0;  // Number of placements in progress.
+};
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_ARENA_H */
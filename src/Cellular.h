@@ -19,9 +19,19 @@
 #ifndef DRAUTOMATON_SRC_CELLULAR_H
 #define DRAUTOMATON_SRC_CELLULAR_H
 
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <tuple>
+#include <vector>
+
+#include "detail/MpscQueue.h"
+#include "detail/ThreadPool.h"
 #include "AbstractGeometry.h"
 #include "Space.h"
 #include "ICellular.h"
+#include "UpdateMode.h"
 
 namespace drautomaton {
 
@@ -38,37 +48,300 @@ Cellular automaton class template. For interface documentation, see
 
 * The CA holds an `AbstractGeometry` which serves as the geometry of
   _both_ `Space` objects. 
+
+* The columns of the space are divided into one block per thread. Each
+  generation, every block is computed by the same worker of `pool_`,
+  which writes into `tmp_`. Then `space_` and `tmp_` are swapped. Once
+  warmed up, `doUpdate` does not allocate memory.
+
+* In `UpdateMode::inPlace`, there is no `tmp_`. Every worker computes
+  the next state of a column into a buffer of its entry of `lines_`,
+  and swaps the buffer with the column of the previous iteration, which
+  no longer needs to be read. The first and the last column of each
+  block are read by the neighboring blocks, so they are kept in their
+  buffers until all workers are done.
+
+* Every column (of `space_`, `tmp_` and the buffers) is only ever written
+  by the worker owning its block, so the ctor lets that worker allocate
+  and first-touch a copy of it (`placeMemory`). On NUMA hosts, the pages
+  of a block thus reside on the node of its worker. `pinThreads` keeps
+  the workers from migrating to another node, and places the memory
+  again. If the memory is obtained from an `Arena`, the copies must
+  neither reuse the blocks of columns freed by other workers nor share
+  a (huge) page with the copies of other workers, so `placeMemory`
+  encloses the copying by `Arena::beginPlacement` and
+  `Arena::endPlacement`.
+
+* While computing a column, the workers compare the new states with the
+  old ones tile by tile and mark the tiles that changed in `changed_`.
+  For every changed cell, the Zobrist keys of its old and new state are
+  XORed into the worker's entry of `deltas_`, which is applied to
+  `hash_` once all workers are done.
+
+* If statistics are enabled, the workers count the new states of their
+  block (and the cells that changed) into their entry of `partials_`,
+  which are summed up once all workers are done.
+
+* `history_` is a ring of the hashes of the last `history_size`
+  generations, which is searched for the current hash after every
+  update.
+
+* `queueIncrement` pushes onto the lock-free `queue_`, which is drained
+  by `doUpdate` right after clearing `changed_`, so that the edited
+  tiles are marked even if the next generation reverts the edit. The
+  bounds are checked against `changed_`, whose dimensions (unlike those
+  of the swapped spaces) are never written.
+
+* `render` and `renderIndices` distribute the tile rows among the
+  workers of `pool_`. Each tile is colorized column-by-column, so that
+  the reads from `space_` are contiguous, while the (row-major) output
+  of one tile stays in cache.
+
+* Likewise, `renderReduced` and `renderReducedIndices` distribute the
+  rows of blocks among the workers. The majority of a block is found
+  using a histogram of the (clamped) states on the worker's stack. Only
+  the entries touched by the block are reset afterwards, so that small
+  blocks don't pay for clearing the whole histogram.
 */
 
 template<typename Rule>
 class Cellular : public ICellular<typename Rule::State>
 {
 public:
-  Cellular(int width, int height);
+  // Create a CA of the specified dimensions whose generations are
+  // computed by `num_threads` threads using `mode`. If `num_threads` is
+  // zero, the number of concurrent threads supported by the system is
+  // used. The memory of the space and of the buffers used to compute
+  // the next generation is obtained from `resource` (for example, an
+  // `Arena`), which must outlive the CA.
+  Cellular(
+      int width,
+      int height,
+      std::size_t num_threads = 0,
+      UpdateMode mode = UpdateMode::buffered,
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    );
 
   const Space<typename Rule::State>& space() const override;
   Space<typename Rule::State>& space() override;
+  const Region& changed() const override;
+  void render(
+      const QRect& rect,
+      const Region& region,
+      const Palette& palette,
+      Color* pixels,
+      const QPoint& origin
+    ) const override;
+  void renderIndices(
+      const QRect& rect,
+      const Region& region,
+      std::uint8_t* indices,
+      const QPoint& origin
+    ) const override;
+  void renderReduced(
+      const QRect& rect,
+      int factor,
+      Reduction reduction,
+      const Region& region,
+      const Palette& palette,
+      Color* pixels,
+      const QPoint& origin
+    ) const override;
+  void renderReducedIndices(
+      const QRect& rect,
+      int factor,
+      Reduction reduction,
+      const Region& region,
+      std::uint8_t* indices,
+      const QPoint& origin
+    ) const override;
+  void setStatisticsEnabled(bool) override;
+  bool statisticsEnabled() const override;
+  const Statistics& statistics() const override;
+  void incrementCells(const std::vector<QPoint>& cells) override;
+  void setCells(const std::vector<QPoint>& cells, const typename Rule::State& state) override;
+  void fillRect(const QRect& rect, const typename Rule::State& state) override;
+  void queueIncrement(int x, int y) override;
+  bool applyQueued() override;
+
+  UpdateMode updateMode() const;
+
+  // Pin the workers to the CPUs the CA may run on, spread evenly and
+  // ordered by NUMA node, so that neighboring blocks share a node. Then
+  // move the memory of every block to the node of its worker. Return
+  // `false` (and leave the workers unpinned) if pinning isn't
+  // supported.
+  bool pinThreads();
+
+  // Return the number of bytes of the space (and of the buffers used to
+  // compute the next generation) residing on each NUMA node, indexed by
+  // node. Empty if the placement can't be determined.
+  std::vector<std::size_t> memoryPerNode() const;
+
+  // Return the number of generations computed so far. The counter may
+  // be set, for example after restoring a `Checkpoint`.
+  std::uint64_t generation() const;
+  void setGeneration(std::uint64_t);
+
+  // Number of recent generations that are compared with the current one
+  // to detect cycles.
+  static constexpr int history_size = 64;
+
+  // Return the Zobrist hash of the current generation. The hash is
+  // maintained incrementally by `doUpdate` and `increment`, so changes
+  // made using the non-const `space()` must be followed by a call of
+  // `rehash`.
+  std::uint64_t hash() const;
+
+  // Recompute the hash from scratch and clear the history of recent
+  // generations.
+  void rehash();
+
+  // Return the period of the cycle the CA has entered, or 0 if none was
+  // detected. The period is the smallest `p <= history_size` such that
+  // the current generation equals the one `p` updates ago (as far as
+  // their hashes tell); a still life has period 1. The history is
+  // cleared by `increment` and `rehash`.
+  int period() const;
 
 public slots:
   void doUpdate() override;
   void increment(int, int) override;
 
+  // Throws in `UpdateMode::inPlace` if `geometry` doesn't preserve
+  // columns.
   void setGeometry(std::shared_ptr<AbstractGeometry<typename Rule::State>> geometry);
 
 private:
-  void processBlock(
-      const Space<typename Rule::State>&,
-      Space<typename Rule::State>&,
-      int,
-      int,
-      std::function<void(int, int, typename Rule::State&)>
+  // Compute the columns `[from_index, to_index)` of the next
+  // generation. Returns the change of the hash caused by the block. If
+  // `count` is set, the statistics of the block are added to
+  // `statistics`.
+  template<bool count>
+  std::uint64_t processBlock(int from_index, int to_index, Statistics& statistics);
+
+  // Same as above, but for the `i`-th block in `UpdateMode::inPlace`.
+  // The first and the last column of the block are left in `lines_[i]`
+  // and must be stored by `storeLines`.
+  template<bool count>
+  std::uint64_t processBlockInPlace(std::size_t i, Statistics& statistics);
+  void storeLines();
+
+  // Replace every column by a copy allocated by the worker owning the
+  // column.
+  void placeMemory();
+
+  // Compute the column `x` of the next generation into `to_data`, see
+  // `processBlock`.
+  template<bool count>
+  std::uint64_t processColumn(
+      int x,
+      Column<typename Rule::State>& to_data,
+      Statistics& statistics
     );
 
+  // Return the hash of the columns `[from_index, to_index)`.
+  std::uint64_t hashBlock(int from_index, int to_index) const;
+
+  // Add the histogram of the columns `[from_index, to_index)` to
+  // `statistics`.
+  void countBlock(int from_index, int to_index, Statistics& statistics) const;
+
+  // Clear the history and enter the current hash into it.
+  void resetHistory();
+
+  // Set the cell `(x, y)` to `state`, update the hash and statistics
+  // and mark the cell in `changed_`. Edits are enclosed by `beginEdit`
+  // and `endEdit`, which emits `updated`.
+  void beginEdit();
+  void assign(int x, int y, const typename Rule::State& state);
+  void endEdit();
+
+  // Throw if any of `cells` is out of bounds.
+  void checkCells(const std::vector<QPoint>& cells) const;
+
+  // Apply the queued increments using `assign`. Returns `false` if
+  // there were none.
+  bool drainQueue();
+
+  // Set every pixel in the marked tiles of `region` within `rect` to
+  // `map(state)`, where `state` is the state of the corresponding cell.
+  // The pixels are wrap-addressed with respect to `origin`, see
+  // `ICellular::render`.
+  template<typename T, typename F>
+  void renderTiles(
+      const QRect& rect,
+      const Region& region,
+      T* out,
+      const QPoint& origin,
+      const F& map
+    ) const;
+
+  // Same as above, but for the single `tile`, which must be contained
+  // in `rect`.
+  template<typename T, typename F>
+  void renderTile(
+      const QRect& tile,
+      const QRect& rect,
+      T* out,
+      const QPoint& origin,
+      const F& map
+    ) const;
+
+  using Histogram = std::array<std::uint32_t, 256>;
+
+  // Return the palette index of `state`, see `renderIndices`.
+  static std::uint8_t index(const typename Rule::State& state);
+
+  // Throw if `region` or `rect` don't fit the space.
+  void checkRenderArguments(const QRect& rect, const Region& region) const;
+
+  // For every block of `factor` x `factor` cells of `rect` which
+  // intersects a tile marked in `region`, set the corresponding
+  // (wrap-addressed) pixel to `reduce(block, histogram)`. The histogram
+  // is zero on entry and must be zero on exit.
+  template<typename T, typename F>
+  void renderBlocks(
+      const QRect& rect,
+      int factor,
+      const Region& region,
+      T* out,
+      const QPoint& origin,
+      const F& reduce
+    ) const;
+
+  // Return the index of the most frequent or largest state in `block`.
+  std::uint8_t reduceIndex(const QRect& block, Reduction, Histogram&) const;
+
+  // Return the average color of the cells in `block`.
+  Color averageColor(const QRect& block, const Palette&) const;
+
+  // Column buffers of a block in `UpdateMode::inPlace`.
+  struct Lines
+  {
+    Column<typename Rule::State> first{};
+    Column<typename Rule::State> previous{};
+    Column<typename Rule::State> current{};
+  };
+
   std::vector<std::tuple<int, int>> blocks_{};
   Space<typename Rule::State> space_;
-  Space<typename Rule::State> tmp_;
+  std::unique_ptr<Space<typename Rule::State>> tmp_{};  // Null in place.
+  std::vector<Lines> lines_{};  // One per block, only in place.
+  Region changed_;
   std::shared_ptr<AbstractGeometry<typename Rule::State>> geometry_{};
   Rule rule_;
+  std::unique_ptr<ThreadPool> pool_{};
+  std::uint64_t generation_ = 0;
+  std::uint64_t hash_ = 0;
+  std::vector<std::uint64_t> deltas_{};  // One per block.
+  std::array<std::uint64_t, history_size> history_{};
+  std::uint64_t history_count_ = 0;
+  int period_ = 0;
+  bool statistics_enabled_ = false;
+  Statistics statistics_{};
+  std::vector<Statistics> partials_{};  // One per block.
+  MpscQueue<QPoint> queue_{};  // Increments scheduled by `queueIncrement`.
 };
 
 } // namespace drautomaton
@@ -16,19 +16,30 @@
  * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
 */
 
-#include <future>
+#include <algorithm>
+#include <atomic>
+#include <utility>
 
+#include "detail/Numa.h"
 #include "detail/Profiling.h"
+#include "detail/Utility.h"
 #include "geometry/Torus.h"
 #include "rules/GameOfLife.h"
+#include "Arena.h"
 
 namespace drautomaton {
 
 template<typename Rule>
-Cellular<Rule>::Cellular(int width, int height)
+Cellular<Rule>::Cellular(
+    int width,
+    int height,
+    std::size_t num_threads,
+    UpdateMode mode,
+    std::pmr::memory_resource* resource
+  )
 :
-  space_{width, height},
-  tmp_{width, height},
+  space_{width, height, resource},
+  changed_{width, height},
   rule_{}
 {
   // Note: These asserts are already enforced by the Space ctor.
@@ -36,7 +47,10 @@ Cellular<Rule>::Cellular(int width, int height)
   assert(height > 0);
 
   // Get number of available threads.
-  auto num_threads = std::thread::hardware_concurrency();
+  if (num_threads == 0)
+  {
+    num_threads = std::thread::hardware_concurrency();
+  }
   if (num_threads == 0)
   {
     throw std::runtime_error{"Failed to obtain number of concurrent threads."};
@@ -57,6 +71,34 @@ Cellular<Rule>::Cellular(int width, int height)
     blocks_.push_back({start, end});
     start = end;
   }
+
+  if (mode == UpdateMode::buffered)
+  {
+    tmp_ = std::make_unique<Space<typename Rule::State>>(width, height, resource);
+  }
+  else
+  {
+    // Columns are swapped with the buffers, so they must share the
+    // resource.
+    lines_.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+      lines_.push_back({
+          Column<typename Rule::State>(height, resource),
+          Column<typename Rule::State>(height, resource),
+          Column<typename Rule::State>(height, resource)
+        });
+    }
+  }
+
+  pool_ = std::make_unique<ThreadPool>(num_threads);
+  deltas_.resize(num_threads);
+  partials_.resize(num_threads);
+  placeMemory();
+  rehash();
+
+  // Nobody has seen the initial state yet.
+  changed_.fill();
 }
 
 template<typename Rule>
@@ -73,30 +115,652 @@ Cellular<Rule>::space()
   return space_;
 }
 
+template<typename Rule>
+const Region&
+Cellular<Rule>::changed() const
+{
+  return changed_;
+}
+
+template<typename Rule>
+template<bool count>
+std::uint64_t
+Cellular<Rule>::processBlock(int from_index, int to_index, Statistics& statistics)
+{
+  DRPROF_THREAD_NAME("Cellular worker");
+  DRPROF_SCOPE("Cellular::processBlock");
+
+  std::uint64_t delta = 0;
+  for (int x = from_index; x < to_index; ++x)
+  {
+    delta ^= processColumn<count>(x, tmp_->data()[x], statistics);
+  }
+  return delta;
+}
+
+template<typename Rule>
+template<bool count>
+std::uint64_t
+Cellular<Rule>::processBlockInPlace(std::size_t i, Statistics& statistics)
+{
+  DRPROF_THREAD_NAME("Cellular worker");
+  DRPROF_SCOPE("Cellular::processBlock");
+
+  int from_index = std::get<0>(blocks_[i]);
+  int to_index = std::get<1>(blocks_[i]);
+  auto& lines = lines_[i];
+  std::uint64_t delta = 0;
+  for (int x = from_index; x < to_index; ++x)
+  {
+    delta ^= processColumn<count>(x, lines.current, statistics);
+    if (x == from_index)
+    {
+      lines.first.swap(lines.current);
+      continue;
+    }
+
+    // The column `x - 1` won't be read again, unless it's the first
+    // column of the block, which the previous block reads.
+    if (x - 1 > from_index)
+    {
+      space_.data()[x - 1].swap(lines.previous);
+    }
+    lines.previous.swap(lines.current);
+  }
+  return delta;
+}
+
 template<typename Rule>
 void
-Cellular<Rule>::processBlock(
-    const Space<typename Rule::State>& from,
-    Space<typename Rule::State>& to,
-    int from_index,
-    int to_index,
-    std::function<void(int, int, typename Rule::State&)> trans
+Cellular<Rule>::storeLines()
+{
+  for (std::size_t i = 0; i < blocks_.size(); ++i)
+  {
+    int from_index = std::get<0>(blocks_[i]);
+    int to_index = std::get<1>(blocks_[i]);
+    if (from_index == to_index)
+    {
+      continue;
+    }
+    space_.data()[from_index].swap(lines_[i].first);
+    if (to_index - 1 > from_index)
+    {
+      space_.data()[to_index - 1].swap(lines_[i].previous);
+    }
+  }
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::placeMemory()
+{
+  auto place = [] (Column<typename Rule::State>& column)
+    {
+      Column<typename Rule::State> copy{column, column.get_allocator()};
+      column.swap(copy);
+    };
+  auto resource = space_.data()[0].get_allocator().resource();
+  auto arena = dynamic_cast<Arena*>(resource);
+  if (arena)
+  {
+    arena->beginPlacement();
+  }
+  try
+  {
+    pool_->run([&] (std::size_t i) {
+        for (int x = std::get<0>(blocks_[i]); x < std::get<1>(blocks_[i]); ++x)
+        {
+          place(space_.data()[x]);
+          if (tmp_)
+          {
+            place(tmp_->data()[x]);
+          }
+        }
+        if (not lines_.empty())
+        {
+          place(lines_[i].first);
+          place(lines_[i].previous);
+          place(lines_[i].current);
+        }
+      });
+  }
+  catch (...)
+  {
+    if (arena)
+    {
+      arena->endPlacement();
+    }
+    throw;
+  }
+  if (arena)
+  {
+    arena->endPlacement();
+  }
+}
+
+template<typename Rule>
+template<bool count>
+std::uint64_t
+Cellular<Rule>::processColumn(
+    int x,
+    Column<typename Rule::State>& to_data,
+    Statistics& statistics
   )
 {
+  std::uint64_t delta = 0;
+  int height = space_.height();
+  const Column<typename Rule::State>& from_data = space_.data()[x];
+  for (int y0 = 0; y0 < height; y0 += Region::tile_size)
+  {
+    int y1 = std::min(y0 + Region::tile_size, height);
+    bool changed = false;
+    for (int y = y0; y < y1; ++y)
+    {
+      to_data[y] = rule_.transition(x, y, space_);
+      if (count)
+      {
+        ++statistics.histogram[index(to_data[y])];
+      }
+      if (to_data[y] != from_data[y])
+      {
+        changed = true;
+        delta ^= detail::zobrist(x, y, static_cast<int>(from_data[y]))
+            ^ detail::zobrist(x, y, static_cast<int>(to_data[y]));
+        if (count)
+        {
+          ++statistics.changed;
+        }
+      }
+    }
+    if (changed)
+    {
+      changed_.mark(x, y0);
+    }
+  }
+  return delta;
+}
+
+template<typename Rule>
+std::uint64_t
+Cellular<Rule>::hashBlock(int from_index, int to_index) const
+{
+  std::uint64_t hash = 0;
   for (int x = from_index; x < to_index; ++x)
   {
-    std::vector<typename Rule::State>& to_data = to.data()[x];
-    for (int y = 0; y < from.height(); ++y)
+    const auto& data = space_.data()[x];
+    for (int y = 0; y < space_.height(); ++y)
+    {
+      hash ^= detail::zobrist(x, y, static_cast<int>(data[y]));
+    }
+  }
+  return hash;
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::countBlock(int from_index, int to_index, Statistics& statistics) const
+{
+  for (int x = from_index; x < to_index; ++x)
+  {
+    for (const auto& state : space_.data()[x])
+    {
+      ++statistics.histogram[index(state)];
+    }
+  }
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::setStatisticsEnabled(bool enabled)
+{
+  statistics_enabled_ = enabled;
+  statistics_ = {};
+  if (not enabled)
+  {
+    return;
+  }
+
+  pool_->run([this] (std::size_t i) {
+      partials_[i] = {};
+      countBlock(std::get<0>(blocks_[i]), std::get<1>(blocks_[i]), partials_[i]);
+    });
+  for (const auto& partial : partials_)
+  {
+    statistics_ += partial;
+  }
+}
+
+template<typename Rule>
+bool
+Cellular<Rule>::statisticsEnabled() const
+{
+  return statistics_enabled_;
+}
+
+template<typename Rule>
+const Statistics&
+Cellular<Rule>::statistics() const
+{
+  return statistics_;
+}
+
+template<typename Rule>
+std::uint64_t
+Cellular<Rule>::hash() const
+{
+  return hash_;
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::rehash()
+{
+  pool_->run([this] (std::size_t i) {
+      deltas_[i] = hashBlock(std::get<0>(blocks_[i]), std::get<1>(blocks_[i]));
+    });
+  hash_ = 0;
+  for (auto delta : deltas_)
+  {
+    hash_ ^= delta;
+  }
+  resetHistory();
+}
+
+template<typename Rule>
+int
+Cellular<Rule>::period() const
+{
+  return period_;
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::resetHistory()
+{
+  history_[0] = hash_;
+  history_count_ = 1;
+  period_ = 0;
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::render(
+    const QRect& rect,
+    const Region& region,
+    const Palette& palette,
+    Color* pixels,
+    const QPoint& origin
+  ) const
+{
+  renderTiles(rect, region, pixels, origin, [&palette] (const typename Rule::State& state) {
+      return palette.color(static_cast<int>(state));
+    });
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::renderIndices(
+    const QRect& rect,
+    const Region& region,
+    std::uint8_t* indices,
+    const QPoint& origin
+  ) const
+{
+  renderTiles(rect, region, indices, origin, [] (const typename Rule::State& state) {
+      return index(state);
+    });
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::renderReduced(
+    const QRect& rect,
+    int factor,
+    Reduction reduction,
+    const Region& region,
+    const Palette& palette,
+    Color* pixels,
+    const QPoint& origin
+  ) const
+{
+  if (reduction == Reduction::average)
+  {
+    renderBlocks(rect, factor, region, pixels, origin, [&] (const QRect& block, Histogram&) {
+        return averageColor(block, palette);
+      });
+  }
+  else
+  {
+    renderBlocks(rect, factor, region, pixels, origin, [&] (const QRect& block, Histogram& histogram) {
+        return palette.color(reduceIndex(block, reduction, histogram));
+      });
+  }
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::renderReducedIndices(
+    const QRect& rect,
+    int factor,
+    Reduction reduction,
+    const Region& region,
+    std::uint8_t* indices,
+    const QPoint& origin
+  ) const
+{
+  // Indices can't be averaged.
+  if (reduction == Reduction::average)
+  {
+    reduction = Reduction::majority;
+  }
+  renderBlocks(rect, factor, region, indices, origin, [&] (const QRect& block, Histogram& histogram) {
+      return reduceIndex(block, reduction, histogram);
+    });
+}
+
+template<typename Rule>
+std::uint8_t
+Cellular<Rule>::index(const typename Rule::State& state)
+{
+  return static_cast<std::uint8_t>(std::min(static_cast<unsigned int>(static_cast<int>(state)), 255u));
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::checkRenderArguments(const QRect& rect, const Region& region) const
+{
+  if (region.width() != space_.width() or region.height() != space_.height())
+  {
+    throw std::runtime_error{"Region does not match Cellular dimensions"};
+  }
+  if (not QRect(0, 0, space_.width(), space_.height()).contains(rect))
+  {
+    throw std::runtime_error{"Render rectangle out of bounds"};
+  }
+}
+
+template<typename Rule>
+template<typename T, typename F>
+void
+Cellular<Rule>::renderBlocks(
+    const QRect& rect,
+    int factor,
+    const Region& region,
+    T* out,
+    const QPoint& origin,
+    const F& reduce
+  ) const
+{
+  checkRenderArguments(rect, region);
+  if (factor < 1)
+  {
+    throw std::runtime_error{"Invalid reduction factor"};
+  }
+
+  DRPROF_START("Cellular::renderReduced");
+  int columns = (rect.width() + factor - 1) / factor;
+  int rows = (rect.height() + factor - 1) / factor;
+  int origin_x = detail::mod(origin.x(), columns);
+  int origin_y = detail::mod(origin.y(), rows);
+  int num_threads = static_cast<int>(pool_->size());
+  pool_->run([&] (std::size_t i) {
+      DRPROF_SCOPE("Cellular::renderBlocks");
+      Histogram histogram{};
+      for (int row = static_cast<int>(i); row < rows; row += num_threads)
+      {
+        T* line = out + ((row + origin_y) % rows) * columns;
+        for (int column = 0; column < columns; ++column)
+        {
+          QRect block = QRect{rect.x() + column * factor, rect.y() + row * factor, factor, factor} & rect;
+          if (region.intersects(block))
+          {
+            line[(column + origin_x) % columns] = reduce(block, histogram);
+          }
+        }
+      }
+    });
+  DRPROF_STOP("Cellular::renderReduced");
+}
+
+template<typename Rule>
+std::uint8_t
+Cellular<Rule>::reduceIndex(const QRect& block, Reduction reduction, Histogram& histogram) const
+{
+  std::uint8_t result = 0;
+  if (reduction == Reduction::maximum)
+  {
+    for (int x = block.left(); x <= block.right(); ++x)
+    {
+      const Column<typename Rule::State>& data = space_.data()[x];
+      for (int y = block.top(); y <= block.bottom(); ++y)
+      {
+        result = std::max(result, index(data[y]));
+      }
+    }
+    return result;
+  }
+
+  std::uint32_t count = 0;
+  for (int x = block.left(); x <= block.right(); ++x)
+  {
+    const Column<typename Rule::State>& data = space_.data()[x];
+    for (int y = block.top(); y <= block.bottom(); ++y)
+    {
+      auto i = index(data[y]);
+      if (++histogram[i] > count)
+      {
+        count = histogram[i];
+        result = i;
+      }
+    }
+  }
+
+  // Reset the entries touched above.
+  for (int x = block.left(); x <= block.right(); ++x)
+  {
+    const Column<typename Rule::State>& data = space_.data()[x];
+    for (int y = block.top(); y <= block.bottom(); ++y)
+    {
+      histogram[index(data[y])] = 0;
+    }
+  }
+  return result;
+}
+
+template<typename Rule>
+Color
+Cellular<Rule>::averageColor(const QRect& block, const Palette& palette) const
+{
+  std::uint64_t red = 0;
+  std::uint64_t green = 0;
+  std::uint64_t blue = 0;
+  std::uint64_t alpha = 0;
+  for (int x = block.left(); x <= block.right(); ++x)
+  {
+    const Column<typename Rule::State>& data = space_.data()[x];
+    for (int y = block.top(); y <= block.bottom(); ++y)
     {
-      trans(x, y, to_data[y]);
+      auto color = palette.color(index(data[y]));
+      red += qRed(color);
+      green += qGreen(color);
+      blue += qBlue(color);
+      alpha += qAlpha(color);
     }
   }
+  auto n = static_cast<std::uint64_t>(block.width()) * block.height();
+  return qRgba(
+      static_cast<int>(red / n),
+      static_cast<int>(green / n),
+      static_cast<int>(blue / n),
+      static_cast<int>(alpha / n)
+    );
+}
+
+template<typename Rule>
+template<typename T, typename F>
+void
+Cellular<Rule>::renderTiles(
+    const QRect& rect,
+    const Region& region,
+    T* out,
+    const QPoint& origin,
+    const F& map
+  ) const
+{
+  checkRenderArguments(rect, region);
+
+  DRPROF_START("Cellular::render");
+  int first_column = rect.left() / Region::tile_size;
+  int last_column = rect.right() / Region::tile_size;
+  int first_row = rect.top() / Region::tile_size;
+  int last_row = rect.bottom() / Region::tile_size;
+  int num_threads = static_cast<int>(pool_->size());
+
+  // The tile rows are distributed round-robin, so that every worker
+  // gets its share of a partially marked region.
+  pool_->run([&] (std::size_t i) {
+      DRPROF_SCOPE("Cellular::renderTiles");
+      for (int row = first_row + static_cast<int>(i); row <= last_row; row += num_threads)
+      {
+        for (int column = first_column; column <= last_column; ++column)
+        {
+          if (region.isMarked(column, row))
+          {
+            renderTile(region.tile(column, row) & rect, rect, out, origin, map);
+          }
+        }
+      }
+    });
+  DRPROF_STOP("Cellular::render");
+}
+
+template<typename Rule>
+template<typename T, typename F>
+void
+Cellular<Rule>::renderTile(
+    const QRect& tile,
+    const QRect& rect,
+    T* out,
+    const QPoint& origin,
+    const F& map
+  ) const
+{
+  // Position of the top-left cell of the tile in `out`. The column of
+  // the pixel wraps around at most once per tile, and so does the row;
+  // the rows are written in two runs, so that the inner loops don't
+  // need to check for the wrap.
+  int width = rect.width();
+  int left = detail::mod(tile.x() - rect.x() + origin.x(), width);
+  int top = detail::mod(tile.y() - rect.y() + origin.y(), rect.height());
+  int split = tile.top() + std::min(tile.height(), rect.height() - top);
+  for (int x = tile.left(); x <= tile.right(); ++x)
+  {
+    const Column<typename Rule::State>& data = space_.data()[x];
+    int column = left + (x - tile.left());
+    if (column >= width)
+    {
+      column -= width;
+    }
+
+    T* pixel = out + top * width + column;
+    for (int y = tile.top(); y < split; ++y)
+    {
+      *pixel = map(data[y]);
+      pixel += width;
+    }
+    pixel = out + column;
+    for (int y = split; y <= tile.bottom(); ++y)
+    {
+      *pixel = map(data[y]);
+      pixel += width;
+    }
+  }
+}
+
+template<typename Rule>
+UpdateMode
+Cellular<Rule>::updateMode() const
+{
+  return tmp_ ? UpdateMode::buffered : UpdateMode::inPlace;
+}
+
+template<typename Rule>
+bool
+Cellular<Rule>::pinThreads()
+{
+  auto cpus = detail::cpus();
+  if (cpus.empty())
+  {
+    return false;
+  }
+
+  std::atomic<bool> pinned{true};
+  pool_->run([&] (std::size_t i) {
+      if (not detail::pinThread({cpus[i * cpus.size() / pool_->size()]}))
+      {
+        pinned = false;
+      }
+    });
+  if (not pinned)
+  {
+    // Undo the pinning of the workers that succeeded.
+    pool_->run([&] (std::size_t) { detail::pinThread(cpus); });
+    return false;
+  }
+  placeMemory();
+  return true;
+}
+
+template<typename Rule>
+std::vector<std::size_t>
+Cellular<Rule>::memoryPerNode() const
+{
+  std::vector<std::size_t> bytes{};
+  auto count = [&] (const Column<typename Rule::State>& column)
+    {
+      return detail::countBytesPerNode(
+          column.data(), column.size() * sizeof(typename Rule::State), bytes
+        );
+    };
+  for (int x = 0; x < space_.width(); ++x)
+  {
+    if (not count(space_.data()[x]) or (tmp_ and not count(tmp_->data()[x])))
+    {
+      return {};
+    }
+  }
+  for (const auto& lines : lines_)
+  {
+    if (not count(lines.first) or not count(lines.previous) or not count(lines.current))
+    {
+      return {};
+    }
+  }
+  return bytes;
+}
+
+template<typename Rule>
+std::uint64_t
+Cellular<Rule>::generation() const
+{
+  return generation_;
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::setGeneration(std::uint64_t generation)
+{
+  generation_ = generation;
 }
 
 template<typename Rule>
 void
 Cellular<Rule>::setGeometry(std::shared_ptr<AbstractGeometry<typename Rule::State>> geometry)
 {
+  if (not tmp_ and geometry and not geometry->preservesColumns())
+  {
+    throw std::runtime_error{"geometry doesn't support in-place updates"};
+  }
   geometry_ = std::move(geometry);
 }
 
@@ -110,50 +774,214 @@ Cellular<Rule>::doUpdate()
   space_.setGeometry(geometry_);
 
   DRPROF_START("Cellular::doUpdate::update");
-  std::vector<std::future<void>> futures{};
-  for (const auto& block : blocks_)
-  {
-    futures.push_back(std::async(
-        std::launch::async,
-        &Cellular<Rule>::processBlock,
-          this,
-          std::ref(space_),
-          std::ref(tmp_),
-          std::get<0>(block),
-          std::get<1>(block),
-          [&] (int x, int y, typename Rule::State& out)
-              {
-                out = rule_.transition(x, y, space_);
-              }
-      ));
-  }
-
-  futures[0].wait();
-  DRPROF_START("Cellular::wait");
-  for (const auto& f : futures)
-  {
-    f.wait();
-  }
-  DRPROF_STOP("Cellular::wait");
-  futures.clear();
+  changed_.clear();
+  if (drainQueue())
+  {
+    resetHistory();
+  }
+  if (statistics_enabled_)
+  {
+    pool_->run([this] (std::size_t i) {
+        partials_[i] = {};
+        deltas_[i] = tmp_
+            ? processBlock<true>(std::get<0>(blocks_[i]), std::get<1>(blocks_[i]), partials_[i])
+            : processBlockInPlace<true>(i, partials_[i]);
+      });
+    statistics_ = {};
+    for (const auto& partial : partials_)
+    {
+      statistics_ += partial;
+    }
+  }
+  else
+  {
+    pool_->run([this] (std::size_t i) {
+        deltas_[i] = tmp_
+            ? processBlock<false>(std::get<0>(blocks_[i]), std::get<1>(blocks_[i]), partials_[i])
+            : processBlockInPlace<false>(i, partials_[i]);
+      });
+  }
   DRPROF_STOP("Cellular::doUpdate::update");
 
+  // Every cell of `tmp_` has been overwritten, so the previous
+  // generation may be recycled as temporary space. In place, only the
+  // first and last column of every block remain to be stored.
   DRPROF_START("Cellular::doUpdate::copy");
-  space_ = std::move(tmp_);
-  tmp_ = Space<typename Rule::State>(space_.width(), space_.height());
-  space_.setGeometry(geometry_);
+  if (tmp_)
+  {
+    std::swap(space_, *tmp_);
+    space_.setGeometry(geometry_);
+  }
+  else
+  {
+    storeLines();
+  }
   DRPROF_STOP("Cellular::doUpdate::copy");
+  ++generation_;
+
+  for (auto delta : deltas_)
+  {
+    hash_ ^= delta;
+  }
+  auto previous = period_;
+  period_ = 0;
+  auto depth = std::min<std::uint64_t>(history_count_, history_size);
+  for (std::uint64_t p = 1; p <= depth; ++p)
+  {
+    if (history_[(history_count_ - p) % history_size] == hash_)
+    {
+      period_ = static_cast<int>(p);
+      break;
+    }
+  }
+  history_[history_count_ % history_size] = hash_;
+  ++history_count_;
 
   DRPROF_STOP("Cellular::doUpdate");
   emit CellularQObject::updated();
+  if (period_ != 0 and period_ != previous)
+  {
+    emit CellularQObject::cycleDetected(period_);
+  }
 }
 
 template<typename Rule>
 void
 Cellular<Rule>::increment(int x, int y)
 {
-  space_.cell(x, y) = rule_.increment(space_.cell(x, y));
+  beginEdit();
+  assign(x, y, rule_.increment(space_.cell(x, y)));
+  endEdit();
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::incrementCells(const std::vector<QPoint>& cells)
+{
+  checkCells(cells);
+  beginEdit();
+  for (const auto& cell : cells)
+  {
+    assign(cell.x(), cell.y(), rule_.increment(space_.cell(cell.x(), cell.y())));
+  }
+  endEdit();
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::setCells(const std::vector<QPoint>& cells, const typename Rule::State& state)
+{
+  checkCells(cells);
+  beginEdit();
+  for (const auto& cell : cells)
+  {
+    assign(cell.x(), cell.y(), state);
+  }
+  endEdit();
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::fillRect(const QRect& rect, const typename Rule::State& state)
+{
+  if (rect.left() < 0 or rect.top() < 0 or rect.right() >= space_.width() or rect.bottom() >= space_.height())
+  {
+    throw std::runtime_error{"rectangle out of Cellular bounds"};
+  }
+
+  beginEdit();
+  for (int x = rect.left(); x <= rect.right(); ++x)
+  {
+    for (int y = rect.top(); y <= rect.bottom(); ++y)
+    {
+      assign(x, y, state);
+    }
+  }
+  endEdit();
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::queueIncrement(int x, int y)
+{
+  if (x < 0 or y < 0 or x >= changed_.width() or y >= changed_.height())
+  {
+    throw std::runtime_error{"cell out of Cellular bounds"};
+  }
+  queue_.push({x, y});
+}
+
+template<typename Rule>
+bool
+Cellular<Rule>::applyQueued()
+{
+  if (queue_.empty())
+  {
+    return false;
+  }
+  beginEdit();
+  drainQueue();
+  endEdit();
+  return true;
+}
+
+template<typename Rule>
+bool
+Cellular<Rule>::drainQueue()
+{
+  bool drained = false;
+  QPoint cell{};
+  while (queue_.pop(cell))
+  {
+    assign(cell.x(), cell.y(), rule_.increment(space_.cell(cell.x(), cell.y())));
+    drained = true;
+  }
+  return drained;
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::beginEdit()
+{
+  changed_.clear();
+  statistics_.changed = 0;
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::assign(int x, int y, const typename Rule::State& state)
+{
+  auto& cell = space_.cell(x, y);
+  hash_ ^= detail::zobrist(x, y, static_cast<int>(cell)) ^ detail::zobrist(x, y, static_cast<int>(state));
+  if (statistics_enabled_)
+  {
+    --statistics_.histogram[index(cell)];
+    ++statistics_.histogram[index(state)];
+    statistics_.changed += state != cell ? 1 : 0;
+  }
+  cell = state;
+  changed_.mark(x, y);
+}
+
+template<typename Rule>
+void
+Cellular<Rule>::endEdit()
+{
+  resetHistory();
   emit CellularQObject::updated();
 }
 
+template<typename Rule>
+void
+Cellular<Rule>::checkCells(const std::vector<QPoint>& cells) const
+{
+  for (const auto& cell : cells)
+  {
+    if (cell.x() < 0 or cell.y() < 0 or cell.x() >= space_.width() or cell.y() >= space_.height())
+    {
+      throw std::runtime_error{"cell out of Cellular bounds"};
+    }
+  }
+}
+
 } // namespace drautomaton
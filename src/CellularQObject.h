@@ -46,6 +46,10 @@ signals:
   // Emit following after an update of the CA's cell states (`doUpdate`,
   // `increment`, ...).
   void updated();
+
+  // Emit following after `updated` if the CA has entered a cycle of
+  // `period` generations (see `Cellular::period`).
+  void cycleDetected(int period);
 };
 
 
@@ -0,0 +1,147 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_CHECKPOINT_H
+#define DRAUTOMATON_SRC_CHECKPOINT_H
+
+#include <cstdint>
+#include <future>
+#include <string>
+#include <type_traits>
+
+#include "detail/MappedFile.h"
+#include "Space.h"
+
+namespace drautomaton {
+
+/* Checkpoint
+
+Versioned binary snapshot of a CA, which holds the IDs of its rule and
+geometry, its dimensions, its generation counter and its cells.
+
+A checkpoint file consists of a header of 128 bytes, followed by the
+cells as raw `T` values, column-by-column (like in `Space`):
+
+  offset  size  content
+       0     8  magic "DRAUTOCP"
+       8     4  format version (currently 1)
+      12     4  0x01020304, to detect a foreign byte order
+      16    32  rule ID, zero-padded
+      48    32  geometry ID, zero-padded
+      80     4  size of `T` in bytes
+      84     4  width
+      88     4  height
+      92     4  reserved
+      96     8  generation
+     104     8  offset of the cells (128)
+     112    16  reserved
+
+As the cells are stored in the memory layout of the machine which wrote
+them, checkpoints are meant to be restored by the same build on the same
+platform. A mismatch of the byte order or the size of `T` is detected.
+The IDs are chosen by the user, for example `"GameOfLife"` and
+`"Torus"`.
+
+The ctor maps the file into memory instead of reading it. The cells may
+be accessed in place using `column`, and are copied into a space using
+`restore` with a single `memcpy` per column. `save` copies the cells
+and writes them on a background thread.
+
+*** Implementation details ***
+
+* `save` writes to `path + ".tmp"` and renames the file once it is
+  complete, so that a crash during the write doesn't destroy the
+  previous checkpoint.
+*/
+
+template<typename T>
+class Checkpoint
+{
+  static_assert(std::is_trivially_copyable<T>::value, "Checkpoint requires trivially copyable states");
+
+public:
+  // Map the checkpoint at `path`. Throws if the file can't be read or
+  // isn't a valid checkpoint of states of type `T`.
+  explicit Checkpoint(const std::string& path);
+
+  const std::string& rule() const;
+  const std::string& geometry() const;
+  int width() const;
+  int height() const;
+  std::uint64_t generation() const;
+
+  // Return the `height()` cells of column `x`. The pointer is valid as
+  // long as the checkpoint.
+  const T* column(int x) const;
+
+  // Copy the cells into `space`. Throws if the dimensions don't match.
+  void restore(Space<T>& space) const;
+
+  // Write a checkpoint of `space` to `path`. The IDs may have at most
+  // 31 characters (throws otherwise).
+  //
+  // The cells are copied before `save` returns, so `space` may be
+  // modified right away, but not concurrently. The file is written on a
+  // background thread. The returned future throws if writing fails; its
+  // dtor waits for the write to complete.
+  static std::future<void> save(
+      const std::string& path,
+      const std::string& rule,
+      const std::string& geometry,
+      std::uint64_t generation,
+      const Space<T>& space
+    );
+
+private:
+  MappedFile file_;
+  std::string rule_{};
+  std::string geometry_{};
+  int width_ = 0;
+  int height_ = 0;
+  std::uint64_t generation_ = 0;
+  const char* cells_ = nullptr;
+};
+
+namespace detail {
+
+// Header of a checkpoint file, see `Checkpoint`.
+struct CheckpointHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  char rule[32];
+  char geometry[32];
+  std::uint32_t state_size;
+  std::int32_t width;
+  std::int32_t height;
+  std::uint32_t reserved0;
+  std::uint64_t generation;
+  std::uint64_t cells;
+  char reserved1[16];
+};
+
+static_assert(sizeof(CheckpointHeader) == 128, "unexpected CheckpointHeader layout");
+
+} // namespace detail
+
+} // namespace drautomaton
+
+#include "Checkpoint.tpp"
+
+#endif /* DRAUTOMATON_SRC_CHECKPOINT_H */
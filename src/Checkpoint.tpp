@@ -0,0 +1,201 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace drautomaton {
+
+namespace detail {
+
+constexpr char checkpoint_magic[8] = {'D', 'R', 'A', 'U', 'T', 'O', 'C', 'P'};
+constexpr std::uint32_t checkpoint_version = 1;
+constexpr std::uint32_t checkpoint_byte_order = 0x01020304;
+
+} // namespace detail
+
+template<typename T>
+Checkpoint<T>::Checkpoint(const std::string& path)
+:
+  file_{path}
+{
+  detail::CheckpointHeader header{};
+  if (file_.size() < sizeof(header))
+  {
+    throw std::runtime_error{"invalid checkpoint: " + path};
+  }
+  std::memcpy(&header, file_.data(), sizeof(header));
+
+  if (std::memcmp(header.magic, detail::checkpoint_magic, sizeof(header.magic)) != 0)
+  {
+    throw std::runtime_error{"invalid checkpoint: " + path};
+  }
+  if (header.version != detail::checkpoint_version)
+  {
+    throw std::runtime_error{"unsupported checkpoint version: " + path};
+  }
+  if (header.byte_order != detail::checkpoint_byte_order)
+  {
+    throw std::runtime_error{"checkpoint has foreign byte order: " + path};
+  }
+  if (header.state_size != sizeof(T))
+  {
+    throw std::runtime_error{"checkpoint state size mismatch: " + path};
+  }
+  if (header.width < 1 or header.height < 1 or header.cells < sizeof(header) or header.cells % alignof(T) != 0)
+  {
+    throw std::runtime_error{"invalid checkpoint: " + path};
+  }
+  auto size = static_cast<std::uint64_t>(header.width) * static_cast<std::uint64_t>(header.height) * sizeof(T);
+  if (file_.size() < header.cells + size)
+  {
+    throw std::runtime_error{"truncated checkpoint: " + path};
+  }
+
+  // The IDs are zero-padded, but not necessarily zero-terminated.
+  rule_.assign(header.rule, strnlen(header.rule, sizeof(header.rule)));
+  geometry_.assign(header.geometry, strnlen(header.geometry, sizeof(header.geometry)));
+  width_ = header.width;
+  height_ = header.height;
+  generation_ = header.generation;
+  cells_ = file_.data() + header.cells;
+}
+
+template<typename T>
+const std::string&
+Checkpoint<T>::rule() const
+{
+  return rule_;
+}
+
+template<typename T>
+const std::string&
+Checkpoint<T>::geometry() const
+{
+  return geometry_;
+}
+
+template<typename T>
+int
+Checkpoint<T>::width() const
+{
+  return width_;
+}
+
+template<typename T>
+int
+Checkpoint<T>::height() const
+{
+  return height_;
+}
+
+template<typename T>
+std::uint64_t
+Checkpoint<T>::generation() const
+{
+  return generation_;
+}
+
+template<typename T>
+const T*
+Checkpoint<T>::column(int x) const
+{
+  // The mapping is page-aligned, and the offset of the cells is a
+  // multiple of `alignof(T)`.
+  return reinterpret_cast<const T*>(cells_ + static_cast<std::size_t>(x) * height_ * sizeof(T));
+}
+
+template<typename T>
+void
+Checkpoint<T>::restore(Space<T>& space) const
+{
+  if (space.width() != width_ or space.height() != height_)
+  {
+    throw std::runtime_error{"Checkpoint does not match Space dimensions"};
+  }
+
+  auto data = space.data();
+  for (int x = 0; x < width_; ++x)
+  {
+    std::memcpy(data[x].data(), column(x), height_ * sizeof(T));
+  }
+}
+
+template<typename T>
+std::future<void>
+Checkpoint<T>::save(
+    const std::string& path,
+    const std::string& rule,
+    const std::string& geometry,
+    std::uint64_t generation,
+    const Space<T>& space
+  )
+{
+  detail::CheckpointHeader header{};
+  if (rule.size() >= sizeof(header.rule) or geometry.size() >= sizeof(header.geometry))
+  {
+    throw std::runtime_error{"Checkpoint ID too long"};
+  }
+
+  std::memcpy(header.magic, detail::checkpoint_magic, sizeof(header.magic));
+  header.version = detail::checkpoint_version;
+  header.byte_order = detail::checkpoint_byte_order;
+  std::copy(rule.begin(), rule.end(), header.rule);
+  std::copy(geometry.begin(), geometry.end(), header.geometry);
+  header.state_size = sizeof(T);
+  header.width = space.width();
+  header.height = space.height();
+  header.generation = generation;
+  header.cells = sizeof(header);
+
+  std::size_t column_size = space.height() * sizeof(T);
+  std::vector<char> buffer(sizeof(header) + space.width() * column_size);
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  auto data = space.data();
+  for (int x = 0; x < space.width(); ++x)
+  {
+    std::memcpy(buffer.data() + sizeof(header) + x * column_size, data[x].data(), column_size);
+  }
+
+  return std::async(
+      std::launch::async,
+      [path, buffer = std::move(buffer)] ()
+      {
+        auto tmp = path + ".tmp";
+        {
+          std::ofstream out{tmp, std::ios::binary | std::ios::trunc};
+          out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+          out.close();
+          if (not out)
+          {
+            throw std::runtime_error{"could not write " + tmp};
+          }
+        }
+        if (std::rename(tmp.c_str(), path.c_str()) != 0)
+        {
+          throw std::runtime_error{"could not rename " + tmp};
+        }
+      }
+    );
+}
+
+} // namespace drautomaton
@@ -19,7 +19,18 @@
 #ifndef DRAUTOMATON_SRC_ICELLULAR_H
 #define DRAUTOMATON_SRC_ICELLULAR_H
 
+#include <cstdint>
+#include <vector>
+
+#include <QPoint>
+#include <QRect>
+
+#include "Color.h"
+#include "Palette.h"
+#include "Reduction.h"
+#include "Region.h"
 #include "Space.h"
+#include "Statistics.h"
 #include "CellularQObject.h"
 
 /* Cellular
@@ -36,9 +47,85 @@ class ICellular : public CellularQObject
 public:
   // Return the CA's underlying cell space. The top-left cell has
   // coordinates (0, 0).
+  //
+  // Changes made to the cells using the non-const overload are not
+  // recorded in `changed()`.
   virtual const drautomaton::Space<T>& space() const = 0;
   virtual drautomaton::Space<T>& space() = 0;
 
+  // Return the tiles of the space which changed in the update announced
+  // by the most recent `updated` signal. The region is only valid until
+  // the next update, so it must be read from a slot directly connected
+  // to `updated`.
+  virtual const drautomaton::Region& changed() const = 0;
+
+  // Write the colors of the cells in `rect` into `pixels`, row-by-row,
+  // top-to-bottom. Only the cells in tiles marked in `region` are
+  // written. `pixels` must hold `rect.width() * rect.height()` colors,
+  // and `region` must have the dimensions of the space.
+  //
+  // The image is wrap-addressed: The color of the cell `(x, y)` of
+  // `rect` (relative to its top-left corner) is written to the pixel
+  // `((x + origin.x()) mod rect.width(), (y + origin.y()) mod
+  // rect.height())`. Pass `{0, 0}` for a plain image.
+  virtual void render(
+      const QRect& rect,
+      const drautomaton::Region& region,
+      const drautomaton::Palette& palette,
+      drautomaton::Color* pixels,
+      const QPoint& origin
+    ) const = 0;
+
+  // Like `render`, but write palette indices instead of colors. The
+  // index of a cell is its state, `static_cast` to `int` and clamped
+  // into `[0, 255]` (negative states are clamped to 255).
+  virtual void renderIndices(
+      const QRect& rect,
+      const drautomaton::Region& region,
+      std::uint8_t* indices,
+      const QPoint& origin
+    ) const = 0;
+
+  // Like `render`, but reduce every block of `factor` x `factor` cells
+  // of `rect` to a single pixel using `reduction`. The blocks are
+  // aligned with the top-left corner of `rect`; the blocks at the right
+  // and bottom edge may be smaller. `pixels` must hold
+  // `ceil(rect.width() / factor) * ceil(rect.height() / factor)` colors.
+  // Only the blocks which intersect a tile marked in `region` are
+  // written. Like in `renderIndices`, states are clamped into
+  // `[0, 255]` before reduction. `origin` is measured in blocks.
+  virtual void renderReduced(
+      const QRect& rect,
+      int factor,
+      drautomaton::Reduction reduction,
+      const drautomaton::Region& region,
+      const drautomaton::Palette& palette,
+      drautomaton::Color* pixels,
+      const QPoint& origin
+    ) const = 0;
+
+  // Like `renderReduced`, but write palette indices instead of colors.
+  virtual void renderReducedIndices(
+      const QRect& rect,
+      int factor,
+      drautomaton::Reduction reduction,
+      const drautomaton::Region& region,
+      std::uint8_t* indices,
+      const QPoint& origin
+    ) const = 0;
+
+  // Enable or disable statistics. While enabled, the statistics of
+  // every generation are accumulated while it is computed, and
+  // `statistics()` returns those of the current generation. Enabling
+  // counts all cells once, so it may also be used to account for
+  // changes made using the non-const `space()`. Disabled by default.
+  virtual void setStatisticsEnabled(bool) = 0;
+  virtual bool statisticsEnabled() const = 0;
+
+  // Return the statistics of the current generation. Only valid while
+  // statistics are enabled.
+  virtual const drautomaton::Statistics& statistics() const = 0;
+
   // Compute the next generation of cells.
   //
   // Listed as public slot in `CellularQObject` - put here so that it
@@ -50,6 +137,29 @@ public:
   // Listed as public slot in `CellularQObject` - put here so that it
   // get's implemented in mock code.
   virtual void increment(int x, int y) = 0;
+
+  // Batch edits: Increment every cell in `cells` (in order, so that a
+  // cell listed twice is incremented twice), set every cell in `cells`
+  // to `state`, or set every cell in `rect` to `state`. All edits are
+  // applied before `updated` is emitted once, with the tiles of all
+  // edited cells marked in `changed()`. Throws, without changing any
+  // cell, if a cell is out of bounds.
+  virtual void incrementCells(const std::vector<QPoint>& cells) = 0;
+  virtual void setCells(const std::vector<QPoint>& cells, const T& state) = 0;
+  virtual void fillRect(const QRect& rect, const T& state) = 0;
+
+  // Schedule an increment of the cell `(x, y)`. Unlike the methods
+  // above, this may be called from any thread at any time, even while a
+  // generation is computed, and never blocks. Queued increments are
+  // applied in order at the start of the next `doUpdate` (before the
+  // next generation is computed) or by `applyQueued`. Throws if the
+  // cell is out of bounds.
+  virtual void queueIncrement(int x, int y) = 0;
+
+  // Apply all queued increments as one batch (see `incrementCells`).
+  // Must be called from the thread which calls `doUpdate`. Returns
+  // `false` (and doesn't emit `updated`) if there were none.
+  virtual bool applyQueued() = 0;
 };
 
 } // namespace drautomaton
@@ -19,8 +19,15 @@
 #ifndef DRAUTOMATON_SRC_IMODEL_H
 #define DRAUTOMATON_SRC_IMODEL_H
 
+#include <cstdint>
 #include <vector>
 #include <QObject>
+#include <QPoint>
+#include <QRect>
+
+#include "Color.h"
+#include "Palette.h"
+#include "Statistics.h"
 
 namespace drautomaton {
 
@@ -39,8 +46,29 @@ and height of the CA's underlying space.
 The size of the vertex container is `width() * height()`, and its values
 represent the states of the cells held in the viewport line-by-line,
 top-to-bottom.  The values are obtained by `static_cast`ing the cell's
-states.  The vertex container is updated every time the CA emits
-`CellularQObject::updated`.
+states.
+
+The model may also provide a _pixel container_, obtained using
+`pixels()`, which holds the colors of the same cells with respect to the
+palette set using `setPalette`. If the pixel container is not empty,
+views should use it instead of colorizing the vertices themselves.
+
+In _indexed mode_ (see `setIndexed`), the model provides an _index
+container_ instead of the pixel container, obtained using `indices()`.
+It holds one palette index of one byte per cell (see
+`ICellular::renderIndices`), which views may colorize on the GPU.
+
+The pixel and index containers are _wrap-addressed_: The vertex `(x, y)`
+is stored at `((x + origin().x()) mod width(), (y + origin().y()) mod
+height())`. This allows the model to pan the viewport by moving the
+origin and refreshing only the newly exposed pixels. Views must apply
+the origin when displaying the containers (for example, by splitting
+the image at the seams).
+
+The pixel (or index) container is updated every time the CA emits
+`CellularQObject::updated`. Only the pixels of the tiles reported by
+`ICellular::changed` are refreshed; their bounding rectangle is
+available through `dirty()`. The vertex container is updated on demand.
 
 The `Cellular` object should be inserted into the model via a ctor.
 */
@@ -56,23 +84,72 @@ public:
   // The vertices are organized row-major. The top-left vertex is
   // vertices()[0].
   virtual const std::vector<int>& vertices() const = 0;
+
+  // Return the current pixels, a vector of size `width() * height()`
+  // organized like the vertices, or an empty vector if the model
+  // doesn't colorize the cells.
+  virtual const std::vector<Color>& pixels() const = 0;
+
+  // Return the current palette indices, a vector of size
+  // `width() * height()` organized like the vertices, or an empty vector
+  // if the model is not in indexed mode.
+  virtual const std::vector<std::uint8_t>& indices() const = 0;
+
   virtual int width() const = 0;
   virtual int height() const = 0;
 
+  // Return the bounding rectangle (in vertex coordinates) of the
+  // vertices which changed in the most recent update. If no vertex
+  // changed, the null rectangle is returned.
+  virtual QRect dirty() const = 0;
+
+  // Return the position of the top-left vertex in the pixel and index
+  // containers. If the model provides neither, this is `(0, 0)`.
+  virtual QPoint origin() const = 0;
+
+  // Return the statistics of the generation shown by the model (see
+  // `ICellular::statistics`). Only valid while statistics are enabled.
+  virtual const Statistics& statistics() const = 0;
+
+  // Increment the CA's cells at `cells` (in vertex coordinates, like
+  // `increment`) as one batch, see `ICellular::incrementCells`. Throws
+  // if a cell is out of bounds.
+  virtual void incrementCells(const std::vector<QPoint>& cells) = 0;
+
 public slots:
   // Compute the CA's next generation.
   virtual void doUpdate() = 0;
 
+  // Compute the CA's next `generations` generations (if positive), but
+  // refresh the pixels and emit `updated` only once.
+  virtual void advance(int generations) = 0;
+
   // Handle CA's update signal.
   virtual void onCellularUpdated() = 0;
 
   // Set the viewport to a rectangle with top left corner at `(x, y)`
   // (in cell coords) and width and height as specified.
+  //
+  // If only the position of the viewport changes, the model may move
+  // the origin instead of refreshing all pixels. It then emits
+  // `updated` (once or several times) with the newly exposed pixels
+  // marked as dirty, instead of `viewportChanged`.
   virtual void setViewport(int x, int y, int width, int height) = 0;
 
   // Increment the CA's cell at `(x, y)`.
   virtual void increment(int x, int y) = 0;
 
+  // Set the palette used to compute the pixels.
+  virtual void setPalette(const Palette&) = 0;
+
+  // Enable or disable indexed mode. In indexed mode, the pixel
+  // container is empty.
+  virtual void setIndexed(bool) = 0;
+
+  // Enable or disable the CA's statistics, see
+  // `ICellular::setStatisticsEnabled`.
+  virtual void setStatisticsEnabled(bool) = 0;
+
 signals:
   // Emit when the vertices are updated.
   void updated();
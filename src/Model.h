@@ -19,41 +19,220 @@
 #ifndef DRAUTOMATON_SRC_MODEL_H
 #define DRAUTOMATON_SRC_MODEL_H
 
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
+#include <QPoint>
 #include <QRect>
 
+#include "detail/TripleBuffer.h"
 #include "IModel.h"
 #include "ICellular.h"
+#include "Reduction.h"
 
 namespace drautomaton {
 
+/* Model
+
+Implementation of `IModel`. For interface documentation, see `IModel.h`.
+
+*** Implementation details ***
+
+* The frame path is fused: On every update, the workers of the CA
+  colorize the changed tiles directly into `pixels_` (or write their
+  indices into `indices_` in indexed mode, see `ICellular::render`).
+  The vertices are not touched.
+
+* `vertices_` is only recomputed when requested after the cells have
+  changed.
+
+* With a level of detail `factor_` larger than one, the changed tiles
+  are rendered using `ICellular::renderReduced`. The pixel buffer then
+  serves as the cache of the reduced image, and only the blocks which
+  intersect a changed tile are recomputed.
+
+* The pixel buffer is wrap-addressed with respect to `origin_` (see
+  `IModel`). `setViewport` moves the viewport by whole blocks, keeping
+  part of it in view, using `pan`: The origin is moved along with the
+  viewport, and only the tiles covering the newly exposed cells are
+  rendered. The horizontal and vertical part of the translation are
+  applied one after the other, each followed by `updated`, so that the
+  exposed cells of either step form a single rectangle. In threaded
+  mode, the exposed cells are rendered into all slots, which share the
+  origin.
+
+* While `advance` computes several generations, `onCellularUpdated`
+  only collects the changed tiles in `batch_`, so that the pixels are
+  refreshed once at the end.
+
+* Using `setThreaded`, the CA may be moved onto a dedicated _simulation
+  thread_. `doUpdate` and `increment` then only post a request to that
+  thread and return immediately; concurrent requests to compute
+  generations are coalesced. Edits are pushed onto the lock-free queue
+  of the CA (see `ICellular::queueIncrement`), which the simulation
+  thread drains at the start of the next generation, so that they never
+  race with the workers computing a generation. The simulation thread renders every
+  completed generation into the back slot of `snapshots_` and publishes
+  it. The GUI thread is notified via a queued call of `onSnapshot`
+  (at most one is pending at any time), which acquires the front slot
+  without blocking and emits `updated`.
+
+  While the model is threaded, the CA must not be accessed except
+  through the model. The thread is stopped by `setThreaded(false)` or
+  the dtor.
+
+* In threaded mode, every tile of the space carries the number of the
+  last generation in which it changed (`stamps_`). Every snapshot
+  records the generation it shows, so that only the tiles stamped
+  later need to be rendered into a recycled slot, or uploaded after
+  acquiring a new front slot. As stamps only grow, this is a
+  conservative estimate.
+
+* `step_mutex_` is held by the simulation thread while it touches the
+  CA or the back slot. The GUI thread only takes it to change the
+  viewport, palette or mode, or to compute the vertices. After such a
+  change, the front slot is re-rendered and copied to the other slots.
+*/
+
 template<typename Rule>
 class Model final : public IModel
 {
 public:
   Model(std::shared_ptr<ICellular<typename Rule::State>>);
   Model(int width, int height);
+  ~Model() override;
+
+  // Move the CA onto a dedicated simulation thread (or back onto the
+  // calling thread).
+  void setThreaded(bool);
+  bool threaded() const;
+
+  // Reduce every block of `factor` x `factor` cells of the viewport to
+  // a single vertex/pixel using `reduction`, so that the width and
+  // height of the model are `ceil(viewport / factor)`. Coordinates
+  // passed to `increment` refer to the blocks; the top-left cell of
+  // the block is incremented. In this mode, the vertices are the
+  // (clamped) palette indices of the reduced blocks, see
+  // `ICellular::renderReducedIndices`.
+  //
+  // To display a viewport of `n` cells width on `m < n` pixels, choose
+  // `factor = ceil(n / m)`. Default is 1 (no reduction).
+  void setLevelOfDetail(int factor, Reduction reduction = Reduction::majority);
+  int levelOfDetail() const;
 
   const std::vector<int>& vertices() const override;
+  const std::vector<Color>& pixels() const override;
+  const std::vector<std::uint8_t>& indices() const override;
   int width() const override;
   int height() const override;
+  QRect dirty() const override;
+  QPoint origin() const override;
+  const Statistics& statistics() const override;
+  void incrementCells(const std::vector<QPoint>& cells) override;
 
 public slots:
   void doUpdate() override;
+  void advance(int generations) override;
   void onCellularUpdated() override;
   void setViewport(int x, int y, int width, int height) override;
   void increment(int x, int y) override;
+  void setPalette(const Palette&) override;
+  void setIndexed(bool) override;
+  void setStatisticsEnabled(bool) override;
 
 private:
+  struct Snapshot
+  {
+    std::vector<Color> pixels{};
+    std::vector<std::uint8_t> indices{};
+    Statistics statistics{};
+    std::uint64_t generation = 0;
+  };
+
+  // Render the tiles marked in `region` into `snapshot`.
+  void render(const Region& region, Snapshot& snapshot) const;
+
+  // Return the pixels (in model coordinates) covered by the cells
+  // `cells` (in space coordinates).
+  QRect reduce(const QRect& cells) const;
+
+  // If `viewport` is the current viewport translated by whole blocks,
+  // and the two overlap, move the viewport and return `true`.
+  // Otherwise, return `false` and do nothing.
+  bool pan(const QRect& viewport);
+
+  // Translate the viewport by `dx` or `dy` cells (one of which must be
+  // zero), and render the exposed cells.
+  void scroll(int dx, int dy);
+
+  // Main loop of the simulation thread.
+  void simulate();
+
+  // Stop the simulation thread. Edits that were not yet applied remain
+  // queued in the CA.
+  void stopThread();
+
+  // Record the tiles marked in `region` as changed in the current
+  // generation.
+  void stamp(const Region& region);
+
+  // Acquire the latest snapshot published by the simulation thread.
+  void onSnapshot();
+
+  // Lock `step_mutex_` if the model is threaded.
+  std::unique_lock<std::mutex> pause() const;
+
+  // Copy the front slot into the other slots.
+  void synchronizeSnapshots();
+
+  // Call `f(column, row)` for every tile that intersects the viewport.
+  template<typename F>
+  void forEachTile(const F& f) const;
+
   // Convert space to vertices.
-  void updateVertices();
+  void updateVertices() const;
+
+  // Colorize the viewport (or only the tiles marked in `region`), and
+  // set `dirty_` accordingly. In indexed mode, update the indices
+  // instead.
+  void updatePixels();
+  void updatePixels(const Region& region);
 
   std::shared_ptr<ICellular<typename Rule::State>> cellular_;
-  std::vector<int> vertices_;
+  mutable std::vector<int> vertices_;
+  mutable bool vertices_stale_ = true;
+  TripleBuffer<Snapshot> snapshots_{};
+  Palette palette_{};
+  bool indexed_ = false;
+  int factor_ = 1;
+  Reduction reduction_ = Reduction::majority;
+  mutable std::vector<std::uint8_t> reduced_{};
 
   QRect viewport_;
+  QPoint origin_{};
+  QRect dirty_{};
+  bool batching_ = false;
+  Region batch_;
+
+  // Threaded mode.
+  QMetaObject::Connection connection_{};
+  bool threaded_ = false;
+  std::thread thread_{};
+  mutable std::mutex step_mutex_{};
+  std::mutex mutex_{};  // Guards the requests below.
+  std::condition_variable wake_{};
+  bool quit_ = false;
+  int requested_ = 0;  // Number of generations to compute.
+  bool edited_ = false;  // Set if edits were queued since the last wake-up.
+  std::atomic<bool> notified_{false};
+  std::uint64_t generation_ = 0;  // Latest generation computed.
+  std::uint64_t shown_ = 0;  // Generation of the front slot.
+  std::unique_ptr<std::atomic<std::uint64_t>[]> stamps_{};
+  Region stale_;  // Scratch space of the simulation thread.
 };
 
 } // namespace drautomaton
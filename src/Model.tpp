@@ -16,6 +16,9 @@
  * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <cstdlib>
+
+#include "detail/Utility.h"
 #include "Cellular.h"
 
 namespace drautomaton {
@@ -25,14 +28,17 @@ Model<Rule>::Model(std::shared_ptr<ICellular<typename Rule::State>> cellular)
 :
   cellular_{std::move(cellular)},
   vertices_(cellular_->space().width() * cellular_->space().height()),
-  viewport_{0, 0, cellular_->space().width(), cellular_->space().height()}
+  viewport_{0, 0, cellular_->space().width(), cellular_->space().height()},
+  batch_{cellular_->space().width(), cellular_->space().height()},
+  stale_{cellular_->space().width(), cellular_->space().height()}
 {
-  QObject::connect(
+  connection_ = QObject::connect(
       cellular_.get(), &CellularQObject::updated,
       this, &IModel::onCellularUpdated
     );
 
-  updateVertices();
+  snapshots_.front().pixels.resize(width() * height());
+  updatePixels();
 }
 
 template<typename Rule>
@@ -41,18 +47,121 @@ Model<Rule>::Model(int width, int height)
   Model{std::make_shared<Cellular<Rule>>(width, height)}
 {}
 
+template<typename Rule>
+Model<Rule>::~Model()
+{
+  if (threaded_)
+  {
+    stopThread();
+  }
+}
+
+template<typename Rule>
+void
+Model<Rule>::setThreaded(bool threaded)
+{
+  if (threaded == threaded_)
+  {
+    return;
+  }
+
+  if (threaded)
+  {
+    QObject::disconnect(connection_);
+    stamps_ = std::make_unique<std::atomic<std::uint64_t>[]>(stale_.columns() * stale_.rows());
+    generation_ = 0;
+    threaded_ = true;
+    synchronizeSnapshots();
+
+    quit_ = false;
+    edited_ = false;
+    notified_ = false;
+    thread_ = std::thread{&Model::simulate, this};
+  }
+  else
+  {
+    stopThread();
+    connection_ = QObject::connect(
+        cellular_.get(), &CellularQObject::updated,
+        this, &IModel::onCellularUpdated
+      );
+
+    // The front slot may lag behind the CA.
+    updatePixels();
+    emit IModel::updated();
+    cellular_->applyQueued();
+  }
+}
+
+template<typename Rule>
+bool
+Model<Rule>::threaded() const
+{
+  return threaded_;
+}
+
 template<typename Rule>
 void
 Model<Rule>::doUpdate()
 {
-  cellular_->doUpdate();
+  advance(1);
+}
+
+template<typename Rule>
+void
+Model<Rule>::advance(int generations)
+{
+  if (generations < 1)
+  {
+    return;
+  }
+
+  if (threaded_)
+  {
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      requested_ = std::max(requested_, generations);
+    }
+    wake_.notify_one();
+    return;
+  }
+
+  if (generations == 1)
+  {
+    cellular_->doUpdate();
+    return;
+  }
+
+  batching_ = true;
+  batch_.clear();
+  for (int i = 0; i < generations; ++i)
+  {
+    cellular_->doUpdate();
+  }
+  batching_ = false;
+  updatePixels(batch_);
+  emit IModel::updated();
 }
 
 template<typename Rule>
 void
 Model<Rule>::onCellularUpdated()
 {
-  updateVertices();
+  if (batching_)
+  {
+    const auto& changed = cellular_->changed();
+    if (changed.width() == batch_.width() and changed.height() == batch_.height())
+    {
+      batch_ |= changed;
+    }
+    else
+    {
+      batch_.fill();
+    }
+    return;
+  }
+
+  updatePixels(cellular_->changed());
   emit IModel::updated();
 }
 
@@ -73,16 +182,458 @@ Model<Rule>::setViewport(int x, int y, int width, int height)
     throw std::runtime_error{"Model viewport out of bounds"};
   }
 
-  viewport_ = {x, y, width, height};
-  vertices_.resize(viewport_.width() * viewport_.height());
+  if (pan({x, y, width, height}))
+  {
+    return;
+  }
+
+  {
+    auto lock = pause();
+    viewport_ = {x, y, width, height};
+    origin_ = {};
+    vertices_.resize(this->width() * this->height());
+    auto& front = snapshots_.front();
+    if (indexed_)
+    {
+      front.indices.resize(this->width() * this->height());
+    }
+    else
+    {
+      front.pixels.resize(this->width() * this->height());
+    }
+    updatePixels();
+    synchronizeSnapshots();
+  }
+
+  emit viewportChanged();
+}
+
+template<typename Rule>
+bool
+Model<Rule>::pan(const QRect& viewport)
+{
+  int dx = viewport.x() - viewport_.x();
+  int dy = viewport.y() - viewport_.y();
+  if (viewport.size() != viewport_.size()
+      or std::abs(dx) >= viewport_.width()
+      or std::abs(dy) >= viewport_.height())
+  {
+    return false;
+  }
+
+  // Partial blocks at the edges would have to be recomputed when they
+  // become whole.
+  if (dx % factor_ != 0 or dy % factor_ != 0
+      or viewport_.width() % factor_ != 0 or viewport_.height() % factor_ != 0)
+  {
+    return false;
+  }
+
+  if (dx != 0)
+  {
+    {
+      auto lock = pause();
+      scroll(dx, 0);
+    }
+    emit IModel::updated();
+  }
+  if (dy != 0)
+  {
+    {
+      auto lock = pause();
+      scroll(0, dy);
+    }
+    emit IModel::updated();
+  }
+  return true;
+}
+
+template<typename Rule>
+void
+Model<Rule>::scroll(int dx, int dy)
+{
+  DRPROF_START("Model::scroll");
+  auto previous = viewport_;
+  viewport_.translate(dx, dy);
+  origin_ = {
+      detail::mod(origin_.x() + dx / factor_, width()),
+      detail::mod(origin_.y() + dy / factor_, height())
+    };
+
+  QRect exposed{};
+  if (dx > 0)
+  {
+    exposed = {previous.right() + 1, viewport_.y(), dx, viewport_.height()};
+  }
+  else if (dx < 0)
+  {
+    exposed = {viewport_.x(), viewport_.y(), -dx, viewport_.height()};
+  }
+  else if (dy > 0)
+  {
+    exposed = {viewport_.x(), previous.bottom() + 1, viewport_.width(), dy};
+  }
+  else
+  {
+    exposed = {viewport_.x(), viewport_.y(), viewport_.width(), -dy};
+  }
+
+  Region region{cellular_->space().width(), cellular_->space().height()};
+  region.mark(exposed);
+  if (threaded_)
+  {
+    snapshots_.forEach([&] (Snapshot& slot) { render(region, slot); });
+  }
+  else
+  {
+    render(region, snapshots_.front());
+  }
+  dirty_ = reduce(exposed);
+  vertices_stale_ = true;
+  DRPROF_STOP("Model::scroll");
+}
+
+template<typename Rule>
+void
+Model<Rule>::setLevelOfDetail(int factor, Reduction reduction)
+{
+  if (factor < 1)
+  {
+    throw std::runtime_error{"Invalid level of detail"};
+  }
+
+  {
+    auto lock = pause();
+    factor_ = factor;
+    reduction_ = reduction;
+    origin_ = {};
+    vertices_.resize(width() * height());
+    auto& front = snapshots_.front();
+    if (indexed_)
+    {
+      front.indices.resize(width() * height());
+    }
+    else
+    {
+      front.pixels.resize(width() * height());
+    }
+    updatePixels();
+    synchronizeSnapshots();
+  }
 
   emit viewportChanged();
-  updateVertices();
+  emit IModel::updated();
+}
+
+template<typename Rule>
+int
+Model<Rule>::levelOfDetail() const
+{
+  return factor_;
+}
+
+template<typename Rule>
+void
+Model<Rule>::setPalette(const Palette& palette)
+{
+  {
+    auto lock = pause();
+    palette_ = palette;
+
+    // The indices don't depend on the palette.
+    if (indexed_)
+    {
+      return;
+    }
+    updatePixels();
+    synchronizeSnapshots();
+  }
+
+  emit IModel::updated();
 }
 
 template<typename Rule>
 void
-Model<Rule>::updateVertices()
+Model<Rule>::setIndexed(bool indexed)
+{
+  if (indexed == indexed_)
+  {
+    return;
+  }
+
+  {
+    auto lock = pause();
+    indexed_ = indexed;
+    auto& front = snapshots_.front();
+    if (indexed_)
+    {
+      front.pixels = {};
+      front.indices.resize(width() * height());
+    }
+    else
+    {
+      front.indices = {};
+      front.pixels.resize(width() * height());
+    }
+    updatePixels();
+    synchronizeSnapshots();
+  }
+
+  emit IModel::updated();
+}
+
+template<typename Rule>
+void
+Model<Rule>::setStatisticsEnabled(bool enabled)
+{
+  auto lock = pause();
+  cellular_->setStatisticsEnabled(enabled);
+  const auto& statistics = cellular_->statistics();
+  snapshots_.forEach([&statistics] (Snapshot& slot) { slot.statistics = statistics; });
+}
+
+template<typename Rule>
+const Statistics&
+Model<Rule>::statistics() const
+{
+  if (threaded_)
+  {
+    return snapshots_.front().statistics;
+  }
+  return cellular_->statistics();
+}
+
+template<typename Rule>
+void
+Model<Rule>::simulate()
+{
+  DRPROF_THREAD_NAME("Model simulation");
+
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true)
+  {
+    wake_.wait(lock, [this] () { return quit_ or requested_ > 0 or edited_; });
+    if (quit_)
+    {
+      return;
+    }
+    int requested = requested_;
+    requested_ = 0;
+    edited_ = false;
+    lock.unlock();
+
+    {
+      std::lock_guard<std::mutex> step_lock{step_mutex_};
+      DRPROF_SCOPE("Model::simulate");
+
+      ++generation_;
+      // Otherwise, `doUpdate` applies the queued edits.
+      if (requested == 0 and cellular_->applyQueued())
+      {
+        stamp(cellular_->changed());
+      }
+      for (int i = 0; i < requested; ++i)
+      {
+        cellular_->doUpdate();
+        stamp(cellular_->changed());
+      }
+
+      // Bring the back slot up to date and publish it.
+      auto& back = snapshots_.back();
+      stale_.clear();
+      forEachTile(
+          [&] (int column, int row)
+          {
+            if (stamps_[row * stale_.columns() + column].load(std::memory_order_relaxed) > back.generation)
+            {
+              stale_.mark(column * Region::tile_size, row * Region::tile_size);
+            }
+          }
+        );
+      if (not stale_.empty())
+      {
+        render(stale_, back);
+      }
+      if (cellular_->statisticsEnabled())
+      {
+        back.statistics = cellular_->statistics();
+      }
+      back.generation = generation_;
+      snapshots_.publish();
+    }
+
+    if (not notified_.exchange(true))
+    {
+      QMetaObject::invokeMethod(this, [this] () { onSnapshot(); }, Qt::QueuedConnection);
+    }
+    lock.lock();
+  }
+}
+
+template<typename Rule>
+void
+Model<Rule>::stopThread()
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    quit_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+  threaded_ = false;
+}
+
+template<typename Rule>
+void
+Model<Rule>::stamp(const Region& region)
+{
+  // If the region doesn't fit the space, we can't trust it.
+  bool all = region.width() != stale_.width() or region.height() != stale_.height();
+  for (int row = 0; row < stale_.rows(); ++row)
+  {
+    for (int column = 0; column < stale_.columns(); ++column)
+    {
+      if (all or region.isMarked(column, row))
+      {
+        stamps_[row * stale_.columns() + column].store(generation_, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+template<typename Rule>
+void
+Model<Rule>::onSnapshot()
+{
+  // Reset the flag first, so that no snapshot published after the
+  // `update()` below goes unnoticed.
+  notified_ = false;
+  if (not threaded_ or not snapshots_.update())
+  {
+    return;
+  }
+
+  DRPROF_START("Model::onSnapshot");
+  dirty_ = {};
+  forEachTile(
+      [this] (int column, int row)
+      {
+        if (stamps_[row * stale_.columns() + column].load(std::memory_order_relaxed) > shown_)
+        {
+          dirty_ |= reduce(stale_.tile(column, row));
+        }
+      }
+    );
+  shown_ = snapshots_.front().generation;
+  vertices_stale_ = true;
+  DRPROF_STOP("Model::onSnapshot");
+
+  emit IModel::updated();
+}
+
+template<typename Rule>
+std::unique_lock<std::mutex>
+Model<Rule>::pause() const
+{
+  std::unique_lock<std::mutex> lock{step_mutex_, std::defer_lock};
+  if (threaded_)
+  {
+    lock.lock();
+  }
+  return lock;
+}
+
+template<typename Rule>
+void
+Model<Rule>::synchronizeSnapshots()
+{
+  if (not threaded_)
+  {
+    return;
+  }
+
+  auto& front = snapshots_.front();
+  front.generation = generation_;
+  shown_ = generation_;
+  snapshots_.forEach(
+      [&front] (Snapshot& slot)
+      {
+        if (&slot != &front)
+        {
+          slot = front;
+        }
+      }
+    );
+}
+
+template<typename Rule>
+void
+Model<Rule>::render(const Region& region, Snapshot& snapshot) const
+{
+  if (factor_ == 1)
+  {
+    if (indexed_)
+    {
+      cellular_->renderIndices(viewport_, region, snapshot.indices.data(), origin_);
+    }
+    else
+    {
+      cellular_->render(viewport_, region, palette_, snapshot.pixels.data(), origin_);
+    }
+  }
+  else
+  {
+    if (indexed_)
+    {
+      cellular_->renderReducedIndices(
+          viewport_, factor_, reduction_, region, snapshot.indices.data(), origin_
+        );
+    }
+    else
+    {
+      cellular_->renderReduced(
+          viewport_, factor_, reduction_, region, palette_, snapshot.pixels.data(), origin_
+        );
+    }
+  }
+}
+
+template<typename Rule>
+QRect
+Model<Rule>::reduce(const QRect& cells) const
+{
+  auto rect = (cells & viewport_).translated(-viewport_.topLeft());
+  if (rect.isEmpty())
+  {
+    return {};
+  }
+  return {
+      QPoint{rect.left() / factor_, rect.top() / factor_},
+      QPoint{rect.right() / factor_, rect.bottom() / factor_}
+    };
+}
+
+template<typename Rule>
+template<typename F>
+void
+Model<Rule>::forEachTile(const F& f) const
+{
+  int first_column = viewport_.left() / Region::tile_size;
+  int last_column = viewport_.right() / Region::tile_size;
+  int first_row = viewport_.top() / Region::tile_size;
+  int last_row = viewport_.bottom() / Region::tile_size;
+  for (int row = first_row; row <= last_row; ++row)
+  {
+    for (int column = first_column; column <= last_column; ++column)
+    {
+      f(column, row);
+    }
+  }
+}
+
+template<typename Rule>
+void
+Model<Rule>::updateVertices() const
 {
   /* Beware! OpenGL/Vulkan draw row-by-row. Therefore, the vertices must
    * be row-major. For example, if `cellular_`has dimensions 3x4, then the
@@ -99,44 +650,177 @@ Model<Rule>::updateVertices()
    * problem by flipping the y-coordinate in the OpenGL shader.
    * */
 
+  auto lock = pause();
   DRPROF_START("Model::updateVertices");
+  if (factor_ > 1)
+  {
+    Region region{stale_.width(), stale_.height()};
+    region.fill();
+    reduced_.resize(width() * height());
+    cellular_->renderReducedIndices(viewport_, factor_, reduction_, region, reduced_.data(), {});
+    std::copy(reduced_.begin(), reduced_.end(), vertices_.begin());
+    vertices_stale_ = false;
+    DRPROF_STOP("Model::updateVertices");
+    return;
+  }
+
+  const auto& space = cellular_->space();
   for (int y = 0; y < viewport_.height(); ++y)
   {
     int offset = y * viewport_.width();
     for (int x = 0; x < viewport_.width(); ++x)
     {
-      vertices_[x + offset] = static_cast<int>(cellular_->space().cell(viewport_.x() + x, viewport_.y() + y));
+      vertices_[x + offset] = static_cast<int>(space.cell(viewport_.x() + x, viewport_.y() + y));
     }
   }
+  vertices_stale_ = false;
   DRPROF_STOP("Model::updateVertices");
 }
 
+template<typename Rule>
+void
+Model<Rule>::updatePixels()
+{
+  Region region{cellular_->space().width(), cellular_->space().height()};
+  region.fill();
+  updatePixels(region);
+}
+
+template<typename Rule>
+void
+Model<Rule>::updatePixels(const Region& region)
+{
+  // If the region doesn't fit the space, we can't trust it.
+  const auto& space = cellular_->space();
+  if (region.width() != space.width() or region.height() != space.height())
+  {
+    updatePixels();
+    return;
+  }
+
+  DRPROF_START("Model::updatePixels");
+  vertices_stale_ = true;
+
+  // Only visit the tiles that intersect the viewport.
+  dirty_ = {};
+  forEachTile(
+      [&] (int column, int row)
+      {
+        if (region.isMarked(column, row))
+        {
+          dirty_ |= reduce(region.tile(column, row));
+        }
+      }
+    );
+
+  if (not dirty_.isEmpty())
+  {
+    render(region, snapshots_.front());
+  }
+  DRPROF_STOP("Model::updatePixels");
+}
+
 template<typename Rule>
 void
 Model<Rule>::increment(int x, int y)
 {
-  cellular_->increment(viewport_.x() + x, viewport_.y() + y);
+  if (threaded_)
+  {
+    cellular_->queueIncrement(viewport_.x() + x * factor_, viewport_.y() + y * factor_);
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      edited_ = true;
+    }
+    wake_.notify_one();
+    return;
+  }
+
+  cellular_->increment(viewport_.x() + x * factor_, viewport_.y() + y * factor_);
+}
+
+template<typename Rule>
+void
+Model<Rule>::incrementCells(const std::vector<QPoint>& cells)
+{
+  std::vector<QPoint> mapped{};
+  mapped.reserve(cells.size());
+  for (const auto& cell : cells)
+  {
+    if (cell.x() < 0 or cell.y() < 0 or cell.x() >= width() or cell.y() >= height())
+    {
+      throw std::runtime_error{"cell out of Model bounds"};
+    }
+    mapped.emplace_back(viewport_.x() + cell.x() * factor_, viewport_.y() + cell.y() * factor_);
+  }
+
+  if (threaded_)
+  {
+    for (const auto& cell : mapped)
+    {
+      cellular_->queueIncrement(cell.x(), cell.y());
+    }
+    {
+      std::lock_guard<std::mutex> lock{mutex_};
+      edited_ = true;
+    }
+    wake_.notify_one();
+    return;
+  }
+
+  cellular_->incrementCells(mapped);
 }
 
 template<typename Rule>
 const std::vector<int>&
 Model<Rule>::vertices() const
 {
+  if (vertices_stale_)
+  {
+    updateVertices();
+  }
   return vertices_;
 }
 
+template<typename Rule>
+const std::vector<Color>&
+Model<Rule>::pixels() const
+{
+  return snapshots_.front().pixels;
+}
+
+template<typename Rule>
+const std::vector<std::uint8_t>&
+Model<Rule>::indices() const
+{
+  return snapshots_.front().indices;
+}
+
 template<typename Rule>
 int
 Model<Rule>::width() const
 {
-  return viewport_.width();
+  return (viewport_.width() + factor_ - 1) / factor_;
 }
 
 template<typename Rule>
 int
 Model<Rule>::height() const
 {
-  return viewport_.height();
+  return (viewport_.height() + factor_ - 1) / factor_;
+}
+
+template<typename Rule>
+QRect
+Model<Rule>::dirty() const
+{
+  return dirty_;
+}
+
+template<typename Rule>
+QPoint
+Model<Rule>::origin() const
+{
+  return origin_;
 }
 
 } // namespace drautomaton
@@ -0,0 +1,91 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Palette.h"
+
+#include <stdexcept>
+
+namespace drautomaton {
+
+Palette::Palette(Color fallback)
+:
+  table_{fallback}
+{}
+
+void
+Palette::setColor(int vertex, Color color)
+{
+  if (vertex < 0)
+  {
+    throw std::runtime_error{"Invalid palette vertex"};
+  }
+
+  // Grow the table, moving the fallback color to the end.
+  if (static_cast<std::size_t>(vertex) >= assigned_.size())
+  {
+    assigned_.resize(vertex + 1, false);
+    table_.resize(vertex + 2, fallback());
+  }
+  table_[vertex] = color;
+  assigned_[vertex] = true;
+}
+
+void
+Palette::setFallback(Color color)
+{
+  for (std::size_t i = 0; i < assigned_.size(); ++i)
+  {
+    if (not assigned_[i])
+    {
+      table_[i] = color;
+    }
+  }
+  table_.back() = color;
+}
+
+Color
+Palette::fallback() const
+{
+  return table_.back();
+}
+
+std::size_t
+Palette::size() const
+{
+  return assigned_.size();
+}
+
+const Color*
+Palette::table() const
+{
+  return table_.data();
+}
+
+bool
+Palette::operator==(const Palette& other) const
+{
+  return table_ == other.table_ and assigned_ == other.assigned_;
+}
+
+bool
+Palette::operator!=(const Palette& other) const
+{
+  return not (*this == other);
+}
+
+} // namespace drautomaton
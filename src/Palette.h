@@ -0,0 +1,83 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_PALETTE_H
+#define DRAUTOMATON_SRC_PALETTE_H
+
+#include <algorithm>
+#include <vector>
+
+#include "Color.h"
+
+namespace drautomaton {
+
+/* Palette
+
+Dense { vertex -> color } mapping. Vertices which have not been assigned
+a color are mapped to the _fallback color_ (solid black by default).
+
+Unlike `std::map`, looking up a color is a single array access, so the
+palette may be used to colorize every cell of a frame, and by several
+threads at once.
+
+*** Implementation details ***
+
+* The colors are stored in a lookup table of `size() + 1` entries, the
+  last of which is the fallback color. Every vertex is clamped into
+  `[0, size()]` (negative vertices are treated as large unsigned
+  integers), so that no branch is required to handle unmapped
+  vertices.
+*/
+
+class Palette
+{
+public:
+  explicit Palette(Color fallback = qRgb(0, 0, 0));
+
+  // Assign `color` to `vertex`. The vertex must not be negative.
+  void setColor(int vertex, Color color);
+
+  // Set the color of all vertices which have not been assigned a color.
+  void setFallback(Color color);
+
+  // Return the color assigned to `vertex`.
+  Color color(int vertex) const;
+  Color fallback() const;
+
+  // Return the number of entries of the lookup table, not counting the
+  // fallback color, and the table itself.
+  std::size_t size() const;
+  const Color* table() const;
+
+  bool operator==(const Palette&) const;
+  bool operator!=(const Palette&) const;
+
+private:
+  std::vector<Color> table_;
+  std::vector<bool> assigned_{};
+};
+
+inline Color
+Palette::color(int vertex) const
+{
+  return table_[std::min<std::size_t>(static_cast<unsigned int>(vertex), assigned_.size())];
+}
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_PALETTE_H */
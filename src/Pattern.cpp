@@ -0,0 +1,174 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Pattern.h"
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <stdexcept>
+
+namespace drautomaton { namespace detail {
+
+namespace {
+
+std::string
+trim(const std::string& s)
+{
+  auto begin = s.find_first_not_of(" \t");
+  if (begin == std::string::npos)
+  {
+    return {};
+  }
+  auto end = s.find_last_not_of(" \t");
+  return s.substr(begin, end - begin + 1);
+}
+
+// Parse a non-negative decimal number at `*p` (after optional blanks)
+// and advance `p` past it.
+std::uint64_t
+parseNumber(const char*& p, std::uint64_t max)
+{
+  while (*p == ' ' or *p == '\t')
+  {
+    ++p;
+  }
+  if (not std::isdigit(static_cast<unsigned char>(*p)))
+  {
+    throw std::runtime_error{"invalid pattern number"};
+  }
+  std::uint64_t result = 0;
+  for (; std::isdigit(static_cast<unsigned char>(*p)); ++p)
+  {
+    result = 10*result + (*p - '0');
+    if (result > max)
+    {
+      throw std::runtime_error{"pattern number out of range"};
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+void
+parseRleHeader(const std::string& line, PatternInfo& info)
+{
+  std::size_t begin = 0;
+  while (begin < line.size())
+  {
+    auto end = std::min(line.find(',', begin), line.size());
+    auto eq = line.find('=', begin);
+    if (eq >= end)
+    {
+      throw std::runtime_error{"invalid RLE header"};
+    }
+    auto key = trim(line.substr(begin, eq - begin));
+
+    // The rule may contain commas (e.g. "B3/S23:T100,50"), so it extends
+    // to the end of the line.
+    if (key == "rule")
+    {
+      info.rule = trim(line.substr(eq + 1));
+      return;
+    }
+
+    auto value = trim(line.substr(eq + 1, end - eq - 1));
+    const char* p = value.c_str();
+    auto number = parseNumber(p, std::numeric_limits<std::int64_t>::max());
+    if (*p != '\0')
+    {
+      throw std::runtime_error{"invalid RLE header"};
+    }
+    if (key == "x")
+    {
+      info.width = static_cast<std::int64_t>(number);
+    }
+    else if (key == "y")
+    {
+      info.height = static_cast<std::int64_t>(number);
+    }
+    begin = end + 1;
+  }
+}
+
+MacrocellNode
+parseMacrocellLine(const std::string& line, const std::vector<MacrocellNode>& nodes)
+{
+  MacrocellNode node{};
+
+  // Leaf of a two-state file, for example "$..*$...*$.***$".
+  if (line[0] == '.' or line[0] == '*' or line[0] == '$')
+  {
+    node.level = 3;
+    int u = 0;
+    int v = 0;
+    for (auto c : line)
+    {
+      if (c == '$')
+      {
+        ++v;
+        u = 0;
+        continue;
+      }
+      if (u >= 8 or v >= 8 or (c != '.' and c != '*'))
+      {
+        throw std::runtime_error{"invalid macrocell leaf"};
+      }
+      if (c == '*')
+      {
+        node.bits |= std::uint64_t{1} << (8*v + u);
+      }
+      ++u;
+    }
+    return node;
+  }
+
+  const char* p = line.c_str();
+  node.level = static_cast<int>(parseNumber(p, 62));
+  if (node.level < 1)
+  {
+    throw std::runtime_error{"invalid macrocell level"};
+  }
+  for (auto& child : node.children)
+  {
+    if (node.level == 1)
+    {
+      child = parseNumber(p, 255);
+      continue;
+    }
+
+    // Children must be defined before their parents.
+    child = parseNumber(p, nodes.size());
+    if (child != 0 and nodes[child - 1].level != node.level - 1)
+    {
+      throw std::runtime_error{"invalid macrocell node"};
+    }
+  }
+  while (*p == ' ' or *p == '\t')
+  {
+    ++p;
+  }
+  if (*p != '\0')
+  {
+    throw std::runtime_error{"invalid macrocell node"};
+  }
+  return node;
+}
+
+}} // namespace drautomaton::detail
@@ -0,0 +1,109 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_PATTERN_H
+#define DRAUTOMATON_SRC_PATTERN_H
+
+#include <array>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "detail/StreamReader.h"
+#include "Space.h"
+
+namespace drautomaton {
+
+/* Pattern
+
+Streaming import of pattern files in the formats used by Golly: RLE
+(including extended multi-state RLE) and macrocell.
+
+The cells are written into a `Space` as they are parsed, without
+building the pattern in memory first. The pattern's top-left corner is
+placed at `(x, y)`, which may be negative; cells outside of the space
+are skipped. State number `n` of the file is written as `states[n]`.
+All functions throw `std::runtime_error` on malformed input or if a
+state number exceeds `states`.
+
+RLE is read in memory bounded by the size of the stream buffer. A
+macrocell file describes a quadtree whose nodes reference each other,
+so the nodes are kept in memory (about 32 bytes per node, which is
+less than the size of the file).
+
+*** Implementation details ***
+
+* In RLE, tags `b` and `.` denote state 0, `o` state 1, `A` to `X`
+  states 1 to 24 and `pA` to `yO` states 25 to 255.
+
+* In macrocell, empty nodes are skipped, so that the cells they cover
+  are not written. Clear the space before reading a macrocell file.
+*/
+
+struct PatternInfo
+{
+  // The pattern's size as declared in the RLE header, or the size of
+  // the root node of a macrocell file.
+  std::int64_t width = 0;
+  std::int64_t height = 0;
+  std::string rule{};
+};
+
+template<typename T>
+PatternInfo readRle(
+    std::istream& in,
+    Space<T>& space,
+    int x,
+    int y,
+    const std::vector<T>& states
+  );
+
+template<typename T>
+PatternInfo readMacrocell(
+    std::istream& in,
+    Space<T>& space,
+    int x,
+    int y,
+    const std::vector<T>& states
+  );
+
+namespace detail {
+
+// Node of a macrocell quadtree. Leaves of two-state files are 8x8
+// bitmaps (bit `8*v + u` is cell `(u, v)`); leaves of multi-state files
+// are 2x2 nodes whose `children` are state numbers. Otherwise,
+// `children` are (one-based) indices of the quadrants nw, ne, sw, se,
+// where 0 denotes an empty quadrant.
+struct MacrocellNode
+{
+  int level;
+  std::uint64_t bits;
+  std::array<std::uint32_t, 4> children;
+};
+
+void parseRleHeader(const std::string& line, PatternInfo& info);
+MacrocellNode parseMacrocellLine(const std::string& line, const std::vector<MacrocellNode>& nodes);
+
+} // namespace detail
+
+} // namespace drautomaton
+
+#include "Pattern.tpp"
+
+#endif /* DRAUTOMATON_SRC_PATTERN_H */
@@ -0,0 +1,266 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace drautomaton {
+
+namespace detail {
+
+// Write `t` into `length` cells of row `row` of `space`, starting at
+// column `left`. Cells outside of the space are skipped.
+template<typename T>
+void
+writeRun(
+    Space<T>& space,
+    std::int64_t left,
+    std::int64_t row,
+    std::int64_t length,
+    const T& t
+  )
+{
+  if (row < 0 or row >= space.height())
+  {
+    return;
+  }
+  auto begin = std::max<std::int64_t>(left, 0);
+  auto end = std::min<std::int64_t>(left + length, space.width());
+  auto data = space.data();
+  for (auto u = begin; u < end; ++u)
+  {
+    data[u][row] = t;
+  }
+}
+
+template<typename T>
+const T&
+patternState(const std::vector<T>& states, std::size_t n)
+{
+  if (n >= states.size())
+  {
+    throw std::runtime_error{"pattern state out of range"};
+  }
+  return states[n];
+}
+
+// Draw the `index`-th (one-based) node of `nodes` with its top-left
+// corner at `(left, top)`.
+template<typename T>
+void
+drawMacrocell(
+    Space<T>& space,
+    std::int64_t left,
+    std::int64_t top,
+    const std::vector<MacrocellNode>& nodes,
+    std::size_t index,
+    const std::vector<T>& states
+  )
+{
+  if (index == 0)
+  {
+    return;
+  }
+  const auto& node = nodes[index - 1];
+  auto size = std::int64_t{1} << node.level;
+  if (left >= space.width() or top >= space.height() or left + size <= 0 or top + size <= 0)
+  {
+    return;
+  }
+
+  if (node.bits != 0)
+  {
+    const auto& alive = patternState(states, 1);
+    for (int v = 0; v < 8; ++v)
+    {
+      for (int u = 0; u < 8; ++u)
+      {
+        if (node.bits & (std::uint64_t{1} << (8*v + u)))
+        {
+          writeRun(space, left + u, top + v, 1, alive);
+        }
+      }
+    }
+  }
+  else if (node.level == 1)
+  {
+    for (int i = 0; i < 4; ++i)
+    {
+      writeRun(space, left + i % 2, top + i / 2, 1, patternState(states, node.children[i]));
+    }
+  }
+  else
+  {
+    auto half = size / 2;
+    for (int i = 0; i < 4; ++i)
+    {
+      drawMacrocell(space, left + (i % 2) * half, top + (i / 2) * half, nodes, node.children[i], states);
+    }
+  }
+}
+
+} // namespace detail
+
+template<typename T>
+PatternInfo
+readRle(
+    std::istream& in,
+    Space<T>& space,
+    int x,
+    int y,
+    const std::vector<T>& states
+  )
+{
+  StreamReader reader{in};
+  PatternInfo info{};
+
+  // Skip comments and read the header line, if any.
+  std::string line{};
+  for (int c = reader.peek(); c != EOF; c = reader.peek())
+  {
+    if (c == '#')
+    {
+      reader.skipLine();
+    }
+    else if (c == ' ' or c == '\t' or c == '\r' or c == '\n')
+    {
+      reader.get();
+    }
+    else
+    {
+      if (c == 'x')
+      {
+        reader.getLine(line);
+        detail::parseRleHeader(line, info);
+      }
+      break;
+    }
+  }
+
+  // Larger run counts would overflow the coordinates.
+  constexpr std::int64_t max_count = std::int64_t{1} << 40;
+  std::int64_t u = 0;
+  std::int64_t v = 0;
+  std::int64_t count = 0;
+  for (int c = reader.get(); c != EOF and c != '!'; c = reader.get())
+  {
+    if ('0' <= c and c <= '9')
+    {
+      count = 10*count + (c - '0');
+      if (count > max_count)
+      {
+        throw std::runtime_error{"RLE run count too large"};
+      }
+      continue;
+    }
+    if (c == ' ' or c == '\t' or c == '\r' or c == '\n')
+    {
+      continue;
+    }
+
+    auto n = count == 0 ? 1 : count;
+    count = 0;
+    if (c == '$')
+    {
+      v += n;
+      u = 0;
+      continue;
+    }
+
+    std::size_t state = 0;
+    if (c == 'b' or c == '.')
+    {
+      state = 0;
+    }
+    else if (c == 'o')
+    {
+      state = 1;
+    }
+    else if ('A' <= c and c <= 'X')
+    {
+      state = c - 'A' + 1;
+    }
+    else if ('p' <= c and c <= 'y')
+    {
+      int d = reader.get();
+      if (d < 'A' or d > 'X')
+      {
+        throw std::runtime_error{"invalid RLE tag"};
+      }
+      state = 24*(c - 'p' + 1) + d - 'A' + 1;
+    }
+    else
+    {
+      throw std::runtime_error{"invalid RLE tag"};
+    }
+
+    detail::writeRun(space, x + u, y + v, n, detail::patternState(states, state));
+    u += n;
+  }
+
+  return info;
+}
+
+template<typename T>
+PatternInfo
+readMacrocell(
+    std::istream& in,
+    Space<T>& space,
+    int x,
+    int y,
+    const std::vector<T>& states
+  )
+{
+  StreamReader reader{in};
+  std::string line{};
+  if (not reader.getLine(line) or line.compare(0, 4, "[M2]") != 0)
+  {
+    throw std::runtime_error{"invalid macrocell header"};
+  }
+
+  PatternInfo info{};
+  std::vector<detail::MacrocellNode> nodes{};
+  while (reader.getLine(line))
+  {
+    if (line.empty())
+    {
+      continue;
+    }
+    if (line[0] == '#')
+    {
+      if (line.compare(0, 3, "#R ") == 0)
+      {
+        info.rule = line.substr(3);
+      }
+      continue;
+    }
+    nodes.push_back(detail::parseMacrocellLine(line, nodes));
+  }
+
+  // The last node is the root.
+  if (nodes.empty())
+  {
+    return info;
+  }
+  info.width = std::int64_t{1} << nodes.back().level;
+  info.height = info.width;
+  detail::drawMacrocell<T>(space, x, y, nodes, nodes.size(), states);
+  return info;
+}
+
+} // namespace drautomaton
@@ -0,0 +1,141 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_RECORDER_H
+#define DRAUTOMATON_SRC_RECORDER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <QObject>
+
+#include "ICellular.h"
+#include "Region.h"
+#include "Recording.h"
+
+namespace drautomaton {
+
+/* Recorder
+
+Writes the history of a CA to disk, one frame per update, in the format
+described in `Recording.h`. Only the tiles marked in
+`ICellular::changed()` are recorded, except for the periodic keyframes,
+which contain the whole space.
+
+The recorder connects to the CA's `updated` signal (directly, so the
+frame is recorded on the thread which updates the CA). Changes made
+using the non-const `ICellular::space()` aren't reported in `changed()`
+and thus are only recorded by the next keyframe.
+
+*** Implementation details ***
+
+* `record` merely copies the changed tiles into one of `queue_size`
+  preallocated slots. The slots are compressed and written by a
+  background thread. If the writer falls behind by `queue_size` frames,
+  `record` blocks until a slot is free, so memory stays bounded by
+  `queue_size` copies of the space.
+
+* Once warmed up, `record` doesn't allocate memory.
+*/
+
+template<typename T>
+class Recorder
+{
+  static_assert(std::is_trivially_copyable<T>::value, "Recorder requires trivially copyable states");
+
+public:
+  // Create the recording `path` and record the current state of
+  // `cellular` as its first (key)frame. Throws if the file can't be
+  // created, or if `keyframe_interval` or `queue_size` is zero.
+  Recorder(
+      std::shared_ptr<ICellular<T>> cellular,
+      const std::string& path,
+      std::uint32_t keyframe_interval = 256,
+      std::size_t queue_size = 8
+    );
+
+  // Calls `finish`, but ignores errors.
+  ~Recorder();
+
+  Recorder(const Recorder&) = delete;
+  Recorder& operator=(const Recorder&) = delete;
+
+  // Return the number of frames recorded so far.
+  std::uint64_t frames() const;
+
+  // Record the current state as the next frame. Called automatically
+  // on every update of the CA.
+  void record();
+
+  // Stop recording, write the remaining frames and the index and close
+  // the file. Throws if writing failed at any point. Subsequent calls
+  // have no effect. Must not be called concurrently with an update of
+  // the CA.
+  void finish();
+
+private:
+  struct Slot
+  {
+    bool keyframe = false;
+    std::vector<std::uint32_t> tiles{};
+    std::vector<T> cells{};  // Tile-by-tile, column-by-column.
+  };
+
+  void write();
+  void writeFrame(const Slot&);
+
+  std::shared_ptr<ICellular<T>> cellular_;
+  Region layout_;
+  QMetaObject::Connection connection_{};
+  std::uint32_t keyframe_interval_;
+  std::uint64_t frames_ = 0;
+  bool finished_ = false;
+
+  // Protected by `mutex_`.
+  std::mutex mutex_{};
+  std::condition_variable produced_{};
+  std::condition_variable consumed_{};
+  std::vector<Slot> slots_;
+  std::size_t head_ = 0;
+  std::size_t count_ = 0;
+  bool quit_ = false;
+  std::exception_ptr error_{};
+
+  // Owned by the writer thread.
+  std::ofstream out_{};
+  std::vector<char> buffer_{};
+  std::vector<detail::RecordingIndexEntry> index_{};
+  std::uint64_t offset_ = 0;
+  std::uint64_t written_ = 0;
+
+  std::thread thread_{};
+};
+
+} // namespace drautomaton
+
+#include "Recorder.tpp"
+
+#endif /* DRAUTOMATON_SRC_RECORDER_H */
@@ -0,0 +1,253 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstring>
+#include <stdexcept>
+
+namespace drautomaton {
+
+template<typename T>
+Recorder<T>::Recorder(
+    std::shared_ptr<ICellular<T>> cellular,
+    const std::string& path,
+    std::uint32_t keyframe_interval,
+    std::size_t queue_size
+  )
+:
+  cellular_{std::move(cellular)},
+  layout_{cellular_->space().width(), cellular_->space().height()},
+  keyframe_interval_{keyframe_interval},
+  slots_(queue_size)
+{
+  if (keyframe_interval == 0 or queue_size == 0)
+  {
+    throw std::runtime_error{"invalid Recorder arguments"};
+  }
+
+  out_.open(path, std::ios::binary | std::ios::trunc);
+  detail::RecordingHeader header{};
+  std::memcpy(header.magic, detail::recording_magic, sizeof(header.magic));
+  header.version = detail::recording_version;
+  header.byte_order = detail::recording_byte_order;
+  header.state_size = sizeof(T);
+  header.width = layout_.width();
+  header.height = layout_.height();
+  header.tile_size = Region::tile_size;
+  header.keyframe_interval = keyframe_interval;
+  out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (not out_)
+  {
+    throw std::runtime_error{"failed to create recording: " + path};
+  }
+  offset_ = sizeof(header);
+
+  record();
+  thread_ = std::thread{&Recorder::write, this};
+  connection_ = QObject::connect(
+      cellular_.get(), &CellularQObject::updated,
+      [this] () { record(); }
+    );
+}
+
+template<typename T>
+Recorder<T>::~Recorder()
+{
+  try
+  {
+    finish();
+  }
+  catch (...)
+  {
+  }
+}
+
+template<typename T>
+std::uint64_t
+Recorder<T>::frames() const
+{
+  return frames_;
+}
+
+template<typename T>
+void
+Recorder<T>::record()
+{
+  if (finished_)
+  {
+    return;
+  }
+
+  const ICellular<T>& cellular = *cellular_;
+  auto data = cellular.space().data();
+  const auto& changed = cellular.changed();
+  bool keyframe = frames_ % keyframe_interval_ == 0;
+
+  // The slot after the queued ones isn't touched by the writer until
+  // `count_` is incremented.
+  std::unique_lock<std::mutex> lock{mutex_};
+  consumed_.wait(lock, [this] () { return count_ < slots_.size(); });
+  auto& slot = slots_[(head_ + count_) % slots_.size()];
+  lock.unlock();
+
+  slot.keyframe = keyframe;
+  slot.tiles.clear();
+  slot.cells.clear();
+  for (int row = 0; row < layout_.rows(); ++row)
+  {
+    for (int column = 0; column < layout_.columns(); ++column)
+    {
+      if (not keyframe and not changed.isMarked(column, row))
+      {
+        continue;
+      }
+      slot.tiles.push_back(row * layout_.columns() + column);
+      auto tile = layout_.tile(column, row);
+      for (int x = tile.left(); x <= tile.right(); ++x)
+      {
+        slot.cells.insert(
+            slot.cells.end(),
+            data[x].begin() + tile.top(),
+            data[x].begin() + tile.bottom() + 1
+          );
+      }
+    }
+  }
+
+  lock.lock();
+  ++count_;
+  lock.unlock();
+  produced_.notify_one();
+  ++frames_;
+}
+
+template<typename T>
+void
+Recorder<T>::finish()
+{
+  if (finished_)
+  {
+    return;
+  }
+  finished_ = true;
+  QObject::disconnect(connection_);
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    quit_ = true;
+  }
+  produced_.notify_one();
+  thread_.join();
+  if (error_)
+  {
+    out_.close();
+    std::rethrow_exception(error_);
+  }
+
+  detail::RecordingTrailer trailer{};
+  trailer.frames = written_;
+  trailer.keyframes = index_.size();
+  trailer.index = offset_;
+  std::memcpy(trailer.magic, detail::recording_index_magic, sizeof(trailer.magic));
+  out_.write(
+      reinterpret_cast<const char*>(index_.data()),
+      index_.size() * sizeof(detail::RecordingIndexEntry)
+    );
+  out_.write(reinterpret_cast<const char*>(&trailer), sizeof(trailer));
+  out_.close();
+  if (not out_)
+  {
+    throw std::runtime_error{"failed to write recording"};
+  }
+}
+
+template<typename T>
+void
+Recorder<T>::write()
+{
+  bool failed = false;
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true)
+  {
+    produced_.wait(lock, [this] () { return count_ > 0 or quit_; });
+    if (count_ == 0)
+    {
+      return;
+    }
+    const auto& slot = slots_[head_];
+    lock.unlock();
+
+    // After an error, the remaining frames are discarded.
+    std::exception_ptr error{};
+    if (not failed)
+    {
+      try
+      {
+        writeFrame(slot);
+      }
+      catch (...)
+      {
+        error = std::current_exception();
+        failed = true;
+      }
+    }
+
+    lock.lock();
+    if (error)
+    {
+      error_ = std::move(error);
+    }
+    head_ = (head_ + 1) % slots_.size();
+    --count_;
+    consumed_.notify_one();
+  }
+}
+
+template<typename T>
+void
+Recorder<T>::writeFrame(const Slot& slot)
+{
+  buffer_.clear();
+  const T* cells = slot.cells.data();
+  for (auto index : slot.tiles)
+  {
+    detail::writeVarint(index, buffer_);
+    auto tile = layout_.tile(index % layout_.columns(), index / layout_.columns());
+    std::size_t n = tile.width() * tile.height();
+    detail::encodeRuns(cells, n, buffer_);
+    cells += n;
+  }
+
+  detail::RecordingFrame frame{};
+  frame.keyframe = slot.keyframe;
+  frame.tiles = slot.tiles.size();
+  frame.size = buffer_.size();
+  if (slot.keyframe)
+  {
+    index_.push_back({written_, offset_});
+  }
+  out_.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+  out_.write(buffer_.data(), buffer_.size());
+  if (not out_)
+  {
+    throw std::runtime_error{"failed to write recording"};
+  }
+  offset_ += sizeof(frame) + buffer_.size();
+  ++written_;
+}
+
+} // namespace drautomaton
@@ -0,0 +1,56 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Recording.h"
+
+#include <stdexcept>
+
+namespace drautomaton { namespace detail {
+
+void
+writeVarint(std::uint64_t value, std::vector<char>& out)
+{
+  while (value >= 0x80)
+  {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+std::uint64_t
+readVarint(const char*& p, const char* end)
+{
+  std::uint64_t result = 0;
+  for (int shift = 0; shift < 64; shift += 7)
+  {
+    if (p == end)
+    {
+      throw std::runtime_error{"invalid recording"};
+    }
+    auto byte = static_cast<unsigned char>(*p++);
+    result |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+    if (not (byte & 0x80))
+    {
+      return result;
+    }
+  }
+  throw std::runtime_error{"invalid recording"};
+}
+
+}} // namespace drautomaton::detail
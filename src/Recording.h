@@ -0,0 +1,129 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_RECORDING_H
+#define DRAUTOMATON_SRC_RECORDING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace drautomaton {
+
+/* Recording
+
+File format of the histories written by `Recorder`. A recording consists
+of a header of 64 bytes, a sequence of frames and an index:
+
+  offset  size  content
+       0     8  magic "DRAUTORC"
+       8     4  format version (currently 1)
+      12     4  0x01020304, to detect a foreign byte order
+      16     4  size of `T` in bytes
+      20     4  width
+      24     4  height
+      28     4  tile size
+      32     4  keyframe interval
+      36    28  reserved
+
+Every frame records one update of the CA. It starts with a
+`RecordingFrame` header, followed by the tiles (see `Region`) that
+changed in the update. A _keyframe_ contains all tiles of the space;
+every `keyframe interval`-th frame (starting with the first) is a
+keyframe. Each tile is stored as its index (`row * columns + column`)
+followed by its cells, column-by-column, as runs. Index and run lengths
+are LEB128 varints, the state of a run is a raw `T`.
+
+The index is a `RecordingIndexEntry` per keyframe, followed by a
+`RecordingTrailer` at the very end of the file. A recording which
+wasn't finished (for example, due to a crash) has no index, but its
+frames may still be read sequentially.
+
+Like `Checkpoint`, recordings are meant to be read on the platform
+which wrote them.
+*/
+
+namespace detail {
+
+struct RecordingHeader
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint32_t state_size;
+  std::int32_t width;
+  std::int32_t height;
+  std::int32_t tile_size;
+  std::uint32_t keyframe_interval;
+  char reserved[28];
+};
+
+struct RecordingFrame
+{
+  std::uint32_t keyframe;
+  std::uint32_t tiles;
+  std::uint64_t size;  // Bytes following the frame header.
+};
+
+struct RecordingIndexEntry
+{
+  std::uint64_t frame;
+  std::uint64_t offset;  // Of the frame header.
+};
+
+struct RecordingTrailer
+{
+  std::uint64_t frames;
+  std::uint64_t keyframes;
+  std::uint64_t index;  // Offset of the first index entry.
+  char magic[8];
+};
+
+static_assert(sizeof(RecordingHeader) == 64, "unexpected RecordingHeader layout");
+static_assert(sizeof(RecordingFrame) == 16, "unexpected RecordingFrame layout");
+static_assert(sizeof(RecordingIndexEntry) == 16, "unexpected RecordingIndexEntry layout");
+static_assert(sizeof(RecordingTrailer) == 32, "unexpected RecordingTrailer layout");
+
+constexpr char recording_magic[8] = {'D', 'R', 'A', 'U', 'T', 'O', 'R', 'C'};
+constexpr char recording_index_magic[8] = {'D', 'R', 'A', 'U', 'T', 'O', 'I', 'X'};
+constexpr std::uint32_t recording_version = 1;
+constexpr std::uint32_t recording_byte_order = 0x01020304;
+
+// Append `value` to `out` as LEB128 varint.
+void writeVarint(std::uint64_t value, std::vector<char>& out);
+
+// Read a LEB128 varint at `p` and advance `p` past it. Throws if the
+// varint exceeds `end`.
+std::uint64_t readVarint(const char*& p, const char* end);
+
+// Append the `n` cells at `cells` to `out` as runs.
+template<typename T>
+void encodeRuns(const T* cells, std::size_t n, std::vector<char>& out);
+
+// Read `n` cells encoded by `encodeRuns` at `p` into `cells` and advance
+// `p` past them. Throws if the runs are malformed or exceed `end`.
+template<typename T>
+void decodeRuns(const char*& p, const char* end, T* cells, std::size_t n);
+
+} // namespace detail
+
+} // namespace drautomaton
+
+#include "Recording.tpp"
+
+#endif /* DRAUTOMATON_SRC_RECORDING_H */
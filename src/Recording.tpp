@@ -0,0 +1,65 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace drautomaton { namespace detail {
+
+template<typename T>
+void
+encodeRuns(const T* cells, std::size_t n, std::vector<char>& out)
+{
+  std::size_t i = 0;
+  while (i < n)
+  {
+    std::size_t j = i + 1;
+    while (j < n and std::memcmp(&cells[j], &cells[i], sizeof(T)) == 0)
+    {
+      ++j;
+    }
+    writeVarint(j - i, out);
+    auto size = out.size();
+    out.resize(size + sizeof(T));
+    std::memcpy(out.data() + size, &cells[i], sizeof(T));
+    i = j;
+  }
+}
+
+template<typename T>
+void
+decodeRuns(const char*& p, const char* end, T* cells, std::size_t n)
+{
+  std::size_t i = 0;
+  while (i < n)
+  {
+    auto length = readVarint(p, end);
+    if (length == 0 or length > n - i or static_cast<std::size_t>(end - p) < sizeof(T))
+    {
+      throw std::runtime_error{"invalid recording"};
+    }
+    T t;
+    std::memcpy(&t, p, sizeof(T));
+    p += sizeof(T);
+    std::fill(cells + i, cells + i + length, t);
+    i += length;
+  }
+}
+
+}} // namespace drautomaton::detail
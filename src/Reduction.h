@@ -0,0 +1,50 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_REDUCTION_H
+#define DRAUTOMATON_SRC_REDUCTION_H
+
+namespace drautomaton {
+
+/* Reduction
+
+Method used to reduce a block of cells to a single pixel (see
+`ICellular::renderReduced`).
+
+- `majority`: The color of the most frequent state in the block. Ties
+  are broken in favor of the state which reached the count first.
+
+- `maximum`: The color of the largest state in the block. For rules with
+  states _dead_/_alive_, this shows a block as alive if any of its cells
+  is alive.
+
+- `average`: The average of the colors of the cells in the block. For
+  rules with two states, this shows the density of the block. In
+  indexed mode, `majority` is used instead.
+*/
+
+enum class Reduction
+{
+  majority,
+  maximum,
+  average
+};
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_REDUCTION_H */
@@ -0,0 +1,246 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Region.h"
+
+#include <stdexcept>
+
+namespace drautomaton {
+
+Region::Region(int width, int height)
+:
+  width_{width},
+  height_{height},
+  columns_{(width + tile_size - 1) / tile_size},
+  rows_{(height + tile_size - 1) / tile_size}
+{
+  if (width < 1 or height < 1)
+  {
+    throw std::runtime_error{"invalid Region dimensions"};
+  }
+
+  tiles_ = std::make_unique<std::atomic<bool>[]>(columns_ * rows_);
+  clear();
+}
+
+Region::Region(const Region& other)
+:
+  width_{other.width_},
+  height_{other.height_},
+  columns_{other.columns_},
+  rows_{other.rows_},
+  tiles_{std::make_unique<std::atomic<bool>[]>(columns_ * rows_)}
+{
+  for (int i = 0; i < columns_ * rows_; ++i)
+  {
+    tiles_[i].store(other.tiles_[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+  }
+}
+
+Region&
+Region::operator=(const Region& other)
+{
+  if (this != &other)
+  {
+    Region copy{other};
+    width_ = copy.width_;
+    height_ = copy.height_;
+    columns_ = copy.columns_;
+    rows_ = copy.rows_;
+    tiles_ = std::move(copy.tiles_);
+  }
+  return *this;
+}
+
+int
+Region::width() const
+{
+  return width_;
+}
+
+int
+Region::height() const
+{
+  return height_;
+}
+
+int
+Region::columns() const
+{
+  return columns_;
+}
+
+int
+Region::rows() const
+{
+  return rows_;
+}
+
+void
+Region::mark(int x, int y)
+{
+  auto& tile = tiles_[x / tile_size + (y / tile_size) * columns_];
+
+  // Avoid writing to (and thus invalidating) the cache line if the tile
+  // is already marked.
+  if (not tile.load(std::memory_order_relaxed))
+  {
+    tile.store(true, std::memory_order_relaxed);
+  }
+}
+
+void
+Region::mark(const QRect& rect)
+{
+  auto clipped = rect & QRect{0, 0, width_, height_};
+  if (clipped.isEmpty())
+  {
+    return;
+  }
+  for (int y = clipped.top() / tile_size; y <= clipped.bottom() / tile_size; ++y)
+  {
+    for (int x = clipped.left() / tile_size; x <= clipped.right() / tile_size; ++x)
+    {
+      mark(x * tile_size, y * tile_size);
+    }
+  }
+}
+
+void
+Region::fill()
+{
+  for (int i = 0; i < columns_ * rows_; ++i)
+  {
+    tiles_[i].store(true, std::memory_order_relaxed);
+  }
+}
+
+void
+Region::clear()
+{
+  for (int i = 0; i < columns_ * rows_; ++i)
+  {
+    tiles_[i].store(false, std::memory_order_relaxed);
+  }
+}
+
+bool
+Region::isMarked(int column, int row) const
+{
+  return tiles_[column + row * columns_].load(std::memory_order_relaxed);
+}
+
+bool
+Region::empty() const
+{
+  for (int i = 0; i < columns_ * rows_; ++i)
+  {
+    if (tiles_[i].load(std::memory_order_relaxed))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+Region::intersects(const QRect& rect) const
+{
+  auto clipped = rect & QRect{0, 0, width_, height_};
+  if (clipped.isEmpty())
+  {
+    return false;
+  }
+  for (int row = clipped.top() / tile_size; row <= clipped.bottom() / tile_size; ++row)
+  {
+    for (int column = clipped.left() / tile_size; column <= clipped.right() / tile_size; ++column)
+    {
+      if (isMarked(column, row))
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+QRect
+Region::tile(int column, int row) const
+{
+  return QRect{column * tile_size, row * tile_size, tile_size, tile_size}
+      & QRect{0, 0, width_, height_};
+}
+
+QRect
+Region::bounds() const
+{
+  QRect result{};
+  for (int row = 0; row < rows_; ++row)
+  {
+    for (int column = 0; column < columns_; ++column)
+    {
+      if (isMarked(column, row))
+      {
+        result |= tile(column, row);
+      }
+    }
+  }
+  return result;
+}
+
+Region&
+Region::operator|=(const Region& other)
+{
+  if (width_ != other.width_ or height_ != other.height_)
+  {
+    throw std::runtime_error{"mismatched Region dimensions"};
+  }
+  for (int i = 0; i < columns_ * rows_; ++i)
+  {
+    if (other.tiles_[i].load(std::memory_order_relaxed))
+    {
+      tiles_[i].store(true, std::memory_order_relaxed);
+    }
+  }
+  return *this;
+}
+
+bool
+Region::operator==(const Region& other) const
+{
+  if (width_ != other.width_ or height_ != other.height_)
+  {
+    return false;
+  }
+  for (int i = 0; i < columns_ * rows_; ++i)
+  {
+    if (tiles_[i].load(std::memory_order_relaxed) != other.tiles_[i].load(std::memory_order_relaxed))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool
+Region::operator!=(const Region& other) const
+{
+  return not (*this == other);
+}
+
+} // namespace drautomaton
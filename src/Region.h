@@ -0,0 +1,104 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_REGION_H
+#define DRAUTOMATON_SRC_REGION_H
+
+#include <atomic>
+#include <memory>
+
+#include <QRect>
+
+namespace drautomaton {
+
+/* Region
+
+Set of tiles of a space of cells, used to record which parts of the
+space have changed. The space is divided into square tiles with side
+length `tile_size`; the tiles at the right and bottom edge may be
+smaller. A tile is _marked_ if any of its cells has changed.
+
+Marking a tile is thread-safe and may be done concurrently from several
+threads, all other modifications are not.
+*/
+
+class Region
+{
+public:
+  static constexpr int tile_size = 32;
+
+  // Create a region for a space of the specified dimensions. Initially,
+  // no tile is marked.
+  Region(int width, int height);
+
+  Region(const Region&);
+  Region& operator=(const Region&);
+
+  // Width and height of the space (in cells).
+  int width() const;
+  int height() const;
+
+  // Number of tiles per row and per column.
+  int columns() const;
+  int rows() const;
+
+  // Mark the tile containing the cell `(x, y)`.
+  void mark(int x, int y);
+
+  // Mark every tile which intersects `rect` (in cells).
+  void mark(const QRect& rect);
+
+  // Mark all tiles, or none.
+  void fill();
+  void clear();
+
+  // Check if the tile in tile column `column` and tile row `row` is
+  // marked.
+  bool isMarked(int column, int row) const;
+
+  // Check if no tile is marked.
+  bool empty() const;
+
+  // Check if any tile which intersects `rect` (in cells) is marked.
+  bool intersects(const QRect& rect) const;
+
+  // Return the rectangle of cells covered by a tile.
+  QRect tile(int column, int row) const;
+
+  // Return the bounding rectangle of all marked tiles (in cells). If
+  // no tile is marked, the null rectangle is returned.
+  QRect bounds() const;
+
+  // Mark every tile that is marked in `other`. Throws if the
+  // dimensions of the regions don't match.
+  Region& operator|=(const Region& other);
+
+  bool operator==(const Region&) const;
+  bool operator!=(const Region&) const;
+
+private:
+  int width_;
+  int height_;
+  int columns_;
+  int rows_;
+  std::unique_ptr<std::atomic<bool>[]> tiles_;
+};
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_REGION_H */
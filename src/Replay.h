@@ -0,0 +1,172 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_REPLAY_H
+#define DRAUTOMATON_SRC_REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "detail/MappedFile.h"
+#include "Cellular.h"
+#include "ICellular.h"
+#include "Recording.h"
+#include "Region.h"
+
+namespace drautomaton {
+
+/* Replay
+
+Implementation of `ICellular` which plays back a recording written by
+`Recorder`, so that it may be shown using `Model` and `View`. Each call
+of `doUpdate` advances to the next frame, `seek` jumps to any frame.
+
+Recordings are read-only: `increment` and the batch edits have no
+effect, and changes made using `space()` are overwritten by the next
+seek.
+
+*** Implementation details ***
+
+* The recording is mapped into memory. `seek` loads the nearest
+  keyframe before the requested frame and applies the following
+  deltas, unless the requested frame is reached faster by applying the
+  deltas following the current frame. Thus, the cost of a seek is
+  bounded by one keyframe and one keyframe interval of deltas,
+  regardless of the length of the recording.
+
+* After each seek, the kernel is asked to read the next
+  `prefetch_bytes` of the recording ahead, so that playback doesn't
+  wait for the disk.
+
+* The frames are decoded into the space of an internal `Cellular`,
+  which is used for rendering only.
+
+* The statistics are updated while the tiles of a frame are decoded.
+  After a seek, `changed` is the number of cells changed by all frames
+  applied.
+
+* Recordings which weren't finished have no index. Their frames are
+  scanned once on construction; a truncated last frame is ignored.
+*/
+
+template<typename Rule>
+class Replay : public ICellular<typename Rule::State>
+{
+public:
+  // Open the recording at `path`, showing its first frame. Throws if
+  // the file isn't a valid recording of states of type `Rule::State`.
+  // `num_threads` is the number of threads used for rendering, see
+  // `Cellular`.
+  explicit Replay(const std::string& path, std::size_t num_threads = 0);
+
+  const Space<typename Rule::State>& space() const override;
+  Space<typename Rule::State>& space() override;
+  const Region& changed() const override;
+  void render(
+      const QRect& rect,
+      const Region& region,
+      const Palette& palette,
+      Color* pixels,
+      const QPoint& origin
+    ) const override;
+  void renderIndices(
+      const QRect& rect,
+      const Region& region,
+      std::uint8_t* indices,
+      const QPoint& origin
+    ) const override;
+  void renderReduced(
+      const QRect& rect,
+      int factor,
+      Reduction reduction,
+      const Region& region,
+      const Palette& palette,
+      Color* pixels,
+      const QPoint& origin
+    ) const override;
+  void renderReducedIndices(
+      const QRect& rect,
+      int factor,
+      Reduction reduction,
+      const Region& region,
+      std::uint8_t* indices,
+      const QPoint& origin
+    ) const override;
+  void setStatisticsEnabled(bool) override;
+  bool statisticsEnabled() const override;
+  const Statistics& statistics() const override;
+  void incrementCells(const std::vector<QPoint>&) override;
+  void setCells(const std::vector<QPoint>&, const typename Rule::State&) override;
+  void fillRect(const QRect&, const typename Rule::State&) override;
+  void queueIncrement(int, int) override;
+  bool applyQueued() override;
+
+  // Return the number of frames of the recording, and the index of the
+  // frame which is shown.
+  std::uint64_t frames() const;
+  std::uint64_t frame() const;
+
+  // Show frame `frame` (or the last frame, if `frame` is out of range)
+  // and emit `updated`. Throws if the recording is corrupt.
+  void seek(std::uint64_t frame);
+
+public slots:
+  // Advance to the next frame. At the last frame, the cells remain
+  // unchanged.
+  void doUpdate() override;
+  void increment(int, int) override;
+
+private:
+  static constexpr std::size_t prefetch_bytes = std::size_t{4} << 20;
+
+  static detail::RecordingHeader readHeader(const MappedFile&, const std::string& path);
+
+  // Return the histogram entry of `state`, see `Statistics`.
+  static std::uint8_t index(const typename Rule::State& state);
+
+  // Read the index from the trailer or, if there is none, by scanning
+  // the frames.
+  void readIndex();
+
+  // Show `frame` without emitting `updated`.
+  void show(std::uint64_t frame);
+
+  // Decode the frame at `offset` into the space and mark its tiles in
+  // `changed_`. Returns the offset of the next frame.
+  std::size_t apply(std::size_t offset);
+
+  MappedFile file_;
+  detail::RecordingHeader header_;
+  Cellular<Rule> display_;
+  Region changed_;
+  std::vector<detail::RecordingIndexEntry> index_{};
+  std::vector<typename Rule::State> cells_{};
+  std::size_t end_ = 0;  // End of the frames.
+  std::uint64_t frames_ = 0;
+  std::uint64_t frame_ = 0;
+  std::size_t next_ = 0;  // Offset of frame `frame_ + 1`.
+  bool statistics_enabled_ = false;
+  Statistics statistics_{};
+};
+
+} // namespace drautomaton
+
+#include "Replay.tpp"
+
+#endif /* DRAUTOMATON_SRC_REPLAY_H */
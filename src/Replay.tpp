@@ -0,0 +1,403 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+namespace drautomaton {
+
+template<typename Rule>
+Replay<Rule>::Replay(const std::string& path, std::size_t num_threads)
+:
+  file_{path},
+  header_{readHeader(file_, path)},
+  display_{header_.width, header_.height, num_threads},
+  changed_{header_.width, header_.height},
+  cells_(Region::tile_size * Region::tile_size)
+{
+  static_assert(
+      std::is_trivially_copyable<typename Rule::State>::value,
+      "Replay requires trivially copyable states"
+    );
+
+  readIndex();
+  if (frames_ == 0 or index_.empty() or index_.front().frame != 0)
+  {
+    throw std::runtime_error{"recording has no frames: " + path};
+  }
+  show(0);
+}
+
+template<typename Rule>
+detail::RecordingHeader
+Replay<Rule>::readHeader(const MappedFile& file, const std::string& path)
+{
+  detail::RecordingHeader header{};
+  if (file.size() < sizeof(header))
+  {
+    throw std::runtime_error{"invalid recording: " + path};
+  }
+  std::memcpy(&header, file.data(), sizeof(header));
+
+  if (std::memcmp(header.magic, detail::recording_magic, sizeof(header.magic)) != 0)
+  {
+    throw std::runtime_error{"invalid recording: " + path};
+  }
+  if (header.version != detail::recording_version)
+  {
+    throw std::runtime_error{"unsupported recording version: " + path};
+  }
+  if (header.byte_order != detail::recording_byte_order)
+  {
+    throw std::runtime_error{"recording has foreign byte order: " + path};
+  }
+  if (header.state_size != sizeof(typename Rule::State))
+  {
+    throw std::runtime_error{"recording state size mismatch: " + path};
+  }
+  if (header.width < 1 or header.height < 1 or header.tile_size != Region::tile_size)
+  {
+    throw std::runtime_error{"invalid recording: " + path};
+  }
+  return header;
+}
+
+template<typename Rule>
+void
+Replay<Rule>::readIndex()
+{
+  auto data = file_.data();
+  auto size = file_.size();
+
+  detail::RecordingTrailer trailer{};
+  if (size >= sizeof(header_) + sizeof(trailer))
+  {
+    std::memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+    auto index_size = trailer.keyframes * sizeof(detail::RecordingIndexEntry);
+    if (
+        std::memcmp(trailer.magic, detail::recording_index_magic, sizeof(trailer.magic)) == 0
+        and trailer.index >= sizeof(header_)
+        and trailer.index + index_size + sizeof(trailer) == size
+      )
+    {
+      index_.resize(trailer.keyframes);
+      std::memcpy(index_.data(), data + trailer.index, index_size);
+      for (const auto& entry : index_)
+      {
+        if (entry.frame >= trailer.frames or entry.offset >= trailer.index)
+        {
+          throw std::runtime_error{"invalid recording index"};
+        }
+      }
+      frames_ = trailer.frames;
+      end_ = trailer.index;
+      return;
+    }
+  }
+
+  // Scan the frames of an unfinished recording.
+  std::size_t offset = sizeof(header_);
+  while (size - offset >= sizeof(detail::RecordingFrame))
+  {
+    detail::RecordingFrame frame{};
+    std::memcpy(&frame, data + offset, sizeof(frame));
+    if (frame.size > size - offset - sizeof(frame))
+    {
+      break;
+    }
+    if (frame.keyframe)
+    {
+      index_.push_back({frames_, offset});
+    }
+    offset += sizeof(frame) + frame.size;
+    ++frames_;
+  }
+  end_ = offset;
+}
+
+template<typename Rule>
+const Space<typename Rule::State>&
+Replay<Rule>::space() const
+{
+  return display_.space();
+}
+
+template<typename Rule>
+Space<typename Rule::State>&
+Replay<Rule>::space()
+{
+  return display_.space();
+}
+
+template<typename Rule>
+const Region&
+Replay<Rule>::changed() const
+{
+  return changed_;
+}
+
+template<typename Rule>
+void
+Replay<Rule>::render(
+    const QRect& rect,
+    const Region& region,
+    const Palette& palette,
+    Color* pixels,
+    const QPoint& origin
+  ) const
+{
+  display_.render(rect, region, palette, pixels, origin);
+}
+
+template<typename Rule>
+void
+Replay<Rule>::renderIndices(
+    const QRect& rect,
+    const Region& region,
+    std::uint8_t* indices,
+    const QPoint& origin
+  ) const
+{
+  display_.renderIndices(rect, region, indices, origin);
+}
+
+template<typename Rule>
+void
+Replay<Rule>::renderReduced(
+    const QRect& rect,
+    int factor,
+    Reduction reduction,
+    const Region& region,
+    const Palette& palette,
+    Color* pixels,
+    const QPoint& origin
+  ) const
+{
+  display_.renderReduced(rect, factor, reduction, region, palette, pixels, origin);
+}
+
+template<typename Rule>
+void
+Replay<Rule>::renderReducedIndices(
+    const QRect& rect,
+    int factor,
+    Reduction reduction,
+    const Region& region,
+    std::uint8_t* indices,
+    const QPoint& origin
+  ) const
+{
+  display_.renderReducedIndices(rect, factor, reduction, region, indices, origin);
+}
+
+template<typename Rule>
+void
+Replay<Rule>::setStatisticsEnabled(bool enabled)
+{
+  statistics_enabled_ = enabled;
+  statistics_ = {};
+  if (not enabled)
+  {
+    return;
+  }
+
+  const auto& space = display_.space();
+  for (int x = 0; x < space.width(); ++x)
+  {
+    for (const auto& state : space.data()[x])
+    {
+      ++statistics_.histogram[index(state)];
+    }
+  }
+}
+
+template<typename Rule>
+bool
+Replay<Rule>::statisticsEnabled() const
+{
+  return statistics_enabled_;
+}
+
+template<typename Rule>
+const Statistics&
+Replay<Rule>::statistics() const
+{
+  return statistics_;
+}
+
+template<typename Rule>
+std::uint8_t
+Replay<Rule>::index(const typename Rule::State& state)
+{
+  return static_cast<std::uint8_t>(std::min(static_cast<unsigned int>(static_cast<int>(state)), 255u));
+}
+
+template<typename Rule>
+std::uint64_t
+Replay<Rule>::frames() const
+{
+  return frames_;
+}
+
+template<typename Rule>
+std::uint64_t
+Replay<Rule>::frame() const
+{
+  return frame_;
+}
+
+template<typename Rule>
+void
+Replay<Rule>::seek(std::uint64_t frame)
+{
+  show(frame);
+  emit CellularQObject::updated();
+}
+
+template<typename Rule>
+void
+Replay<Rule>::doUpdate()
+{
+  seek(frame_ + 1);
+}
+
+template<typename Rule>
+void
+Replay<Rule>::increment(int, int)
+{
+}
+
+template<typename Rule>
+void
+Replay<Rule>::incrementCells(const std::vector<QPoint>&)
+{
+}
+
+template<typename Rule>
+void
+Replay<Rule>::setCells(const std::vector<QPoint>&, const typename Rule::State&)
+{
+}
+
+template<typename Rule>
+void
+Replay<Rule>::fillRect(const QRect&, const typename Rule::State&)
+{
+}
+
+template<typename Rule>
+void
+Replay<Rule>::queueIncrement(int, int)
+{
+}
+
+template<typename Rule>
+bool
+Replay<Rule>::applyQueued()
+{
+  return false;
+}
+
+template<typename Rule>
+void
+Replay<Rule>::show(std::uint64_t frame)
+{
+  frame = std::min(frame, frames_ - 1);
+  changed_.clear();
+  statistics_.changed = 0;
+
+  // The last keyframe at or before `frame`.
+  auto keyframe = std::prev(std::upper_bound(
+      index_.begin(), index_.end(), frame,
+      [] (std::uint64_t f, const detail::RecordingIndexEntry& entry) { return f < entry.frame; }
+    ));
+
+  std::uint64_t current = frame_ + 1;
+  std::size_t offset = next_;
+  if (next_ == 0 or frame < frame_ or keyframe->frame > frame_)
+  {
+    current = keyframe->frame;
+    offset = keyframe->offset;
+  }
+  for (; current <= frame; ++current)
+  {
+    offset = apply(offset);
+  }
+
+  frame_ = frame;
+  next_ = offset;
+  file_.prefetch(next_, prefetch_bytes);
+}
+
+template<typename Rule>
+std::size_t
+Replay<Rule>::apply(std::size_t offset)
+{
+  detail::RecordingFrame frame{};
+  if (end_ < offset or end_ - offset < sizeof(frame))
+  {
+    throw std::runtime_error{"invalid recording frame"};
+  }
+  std::memcpy(&frame, file_.data() + offset, sizeof(frame));
+  if (frame.size > end_ - offset - sizeof(frame))
+  {
+    throw std::runtime_error{"invalid recording frame"};
+  }
+
+  const char* p = file_.data() + offset + sizeof(frame);
+  const char* end = p + frame.size;
+  auto data = display_.space().data();
+  auto num_tiles = static_cast<std::uint64_t>(changed_.columns()) * changed_.rows();
+  for (std::uint32_t i = 0; i < frame.tiles; ++i)
+  {
+    auto tile_index = detail::readVarint(p, end);
+    if (tile_index >= num_tiles)
+    {
+      throw std::runtime_error{"invalid recording frame"};
+    }
+    auto tile = changed_.tile(tile_index % changed_.columns(), tile_index / changed_.columns());
+    detail::decodeRuns(p, end, cells_.data(), tile.width() * tile.height());
+
+    auto cell = cells_.begin();
+    for (int x = tile.left(); x <= tile.right(); ++x)
+    {
+      auto column = data[x].begin() + tile.top();
+      if (statistics_enabled_)
+      {
+        for (int v = 0; v < tile.height(); ++v)
+        {
+          if (column[v] != cell[v])
+          {
+            --statistics_.histogram[index(column[v])];
+            ++statistics_.histogram[index(cell[v])];
+            ++statistics_.changed;
+          }
+        }
+      }
+      std::copy(cell, cell + tile.height(), column);
+      cell += tile.height();
+    }
+    changed_.mark(tile.left(), tile.top());
+  }
+  return offset + sizeof(frame) + frame.size;
+}
+
+} // namespace drautomaton
@@ -20,6 +20,7 @@
 #define DRAUTOMATON_SRC_SPACE_H
 
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -34,6 +35,11 @@ a cellular automaton./
 The space may be equipped with a _geometry_, which transforms
 coordinates into the range of the underlying vector.
 
+The cells are stored column by column. The memory of every `Column` is
+obtained from the `std::pmr::memory_resource` passed to the ctor (for
+example, an `Arena`), which must outlive the space. Copies of the space
+use the default resource.
+
 
 */
 
@@ -43,7 +49,11 @@ template<typename T>
 class Space
 {
 public:
-  Space(int width, int height);
+  Space(
+      int width,
+      int height,
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    );
 
   int width() const;
   int height() const;
@@ -59,8 +69,8 @@ public:
   const T& cell(int x, int y) const;
 
   // Return pointer to vector memory (for concurrent access).
-  std::vector<T>* data();
-  const std::vector<T>* data() const;
+  Column<T>* data();
+  const Column<T>* data() const;
 
   void setGeometry(std::shared_ptr<AbstractGeometry<T>>);
 
@@ -77,7 +87,9 @@ public:
   // each character of each string specifies one cell. The data is
   // translated from character to `T` using `dict`.
   //
-  // Note: The strings are not required to have the same length.
+  // Note: The strings are not required to have the same length. To
+  // load pattern files, use `readRle` or `readMacrocell` (see
+  // `Pattern.h`) instead.
   void fill(
       int x,
       int y,
@@ -86,7 +98,7 @@ public:
     );
 
 private:
-  std::vector<std::vector<T>> space_{};
+  std::vector<Column<T>> space_{};
   std::shared_ptr<AbstractGeometry<T>> geometry_{};
 };
 
@@ -16,23 +16,24 @@
  * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <array>
 #include <cassert>
+#include <stdexcept>
 
 namespace drautomaton {
 
 template<typename T>
-Space<T>::Space(int width, int height)
-:
-  space_(width)
+Space<T>::Space(int width, int height, std::pmr::memory_resource* resource)
 {
   if (width < 1 or height < 1)
   {
     throw std::runtime_error{"invalid Space dimensions"};
   }
 
+  space_.reserve(width);
   for (int x = 0; x < width; ++x)
   {
-    space_[x].resize(height);
+    space_.emplace_back(height, resource);
   }
 }
 
@@ -80,14 +81,14 @@ Space<T>::geometricCell(int x, int y) const
 }
 
 template<typename T>
-std::vector<T>*
+Column<T>*
 Space<T>::data()
 {
   return space_.data();
 }
 
 template<typename T>
-const std::vector<T>*
+const Column<T>*
 Space<T>::data() const
 {
   return space_.data();
@@ -115,13 +116,28 @@ Space<T>::fill(
     const std::vector<std::string>& data
   )
 {
+  // Only single-character keys can match, so resolve them once instead
+  // of hashing a string per cell.
+  std::array<const T*, 256> table{};
+  for (const auto& p : dict)
+  {
+    if (p.first.size() == 1)
+    {
+      table[static_cast<unsigned char>(p.first[0])] = &p.second;
+    }
+  }
+
   for (std::size_t v = 0; v < data.size(); ++v)
   {
-    auto line = data[v];
+    const auto& line = data[v];
     for (std::size_t u = 0; u < line.size(); ++u)
     {
-      std::string key{line[u]};
-      space_[x + u][y + v] = dict.at(key);
+      auto t = table[static_cast<unsigned char>(line[u])];
+      if (not t)
+      {
+        throw std::out_of_range{"Space::fill: character not in dict"};
+      }
+      space_[x + u][y + v] = *t;
     }
   }
 }
@@ -0,0 +1,42 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Statistics.h"
+
+#include <numeric>
+
+namespace drautomaton {
+
+std::uint64_t
+Statistics::population() const
+{
+  return std::accumulate(histogram.begin() + 1, histogram.end(), std::uint64_t{0});
+}
+
+Statistics&
+Statistics::operator+=(const Statistics& other)
+{
+  for (std::size_t i = 0; i < histogram.size(); ++i)
+  {
+    histogram[i] += other.histogram[i];
+  }
+  changed += other.changed;
+  return *this;
+}
+
+} // namespace drautomaton
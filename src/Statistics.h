@@ -0,0 +1,55 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_STATISTICS_H
+#define DRAUTOMATON_SRC_STATISTICS_H
+
+#include <array>
+#include <cstdint>
+
+namespace drautomaton {
+
+/* Statistics
+
+Statistics of one generation of a CA (see
+`ICellular::setStatisticsEnabled`).
+
+- `histogram`: The number of cells per state. Like palette indices (see
+  `ICellular::renderIndices`), states are clamped into `[0, 255]`.
+
+- `changed`: The number of cells which changed in the most recent
+  update.
+
+The _population_ is the number of cells whose state isn't 0.
+*/
+
+struct Statistics
+{
+  std::array<std::uint64_t, 256> histogram{};
+  std::uint64_t changed = 0;
+
+  std::uint64_t population() const;
+
+  // Add the counts of `other`, for example those of another part of
+  // the space.
+  Statistics& operator+=(const Statistics& other);
+};
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_STATISTICS_H */
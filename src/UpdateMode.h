@@ -0,0 +1,48 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_UPDATEMODE_H
+#define DRAUTOMATON_SRC_UPDATEMODE_H
+
+namespace drautomaton {
+
+/* UpdateMode
+
+Method used by `Cellular` to compute the next generation.
+
+- `buffered`: The next generation is written into a second space, which
+  is then swapped with the first one. Requires twice the memory of the
+  space.
+
+- `inPlace`: The next generation overwrites the space column by column.
+  Only a few columns per thread are buffered, so that the memory
+  required is about that of the space. Requires a rule whose
+  transitions only read the columns adjacent to the cell, and a
+  geometry which preserves columns (see
+  `AbstractGeometry::preservesColumns`).
+*/
+
+enum class UpdateMode
+{
+  buffered,
+  inPlace
+};
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_UPDATEMODE_H */
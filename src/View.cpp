@@ -18,11 +18,12 @@
 
 #include "View.h"
 
+#include <algorithm>
 #include <cmath>
-#include <QOpenGLContext>
-#include <QOpenGLFunctions>
-#include <QSGSimpleTextureNode>
 
+#include "detail/Colorize.h"
+#include "detail/TiledNode.h"
+#include "detail/Utility.h"
 #include "Model.h"
 
 namespace drautomaton {
@@ -43,6 +44,11 @@ View::View()
       &timer_, &QTimer::timeout,
       &gate_, &Gate::lhs
     );
+  QObject::connect(
+      &gate_, &Gate::ready,
+      this, [this] () { advance(batch_); }
+    );
+  clock_.start();
 
   // Default framerate value.
   setFramerate(1);
@@ -53,55 +59,96 @@ View::updatePaintNode(QSGNode* old, UpdatePaintNodeData*)
 {
   DRPROF_START("View::updatePaintNode");
   assert(model_);
+  auto node = useIndices() ? updateIndexedNode(old) : updateTextureNode(old);
+  DRPROF_STOP("View::updatePaintNode");
+  return node;
+}
 
-  auto openGL = QOpenGLContext::currentContext()->functions();
-  auto node = static_cast<QSGSimpleTextureNode*>(old);
+QSGNode*
+View::updateTextureNode(QSGNode* old)
+{
+  auto node = dynamic_cast<TiledTextureNode*>(old);
 
-  // Initialize texture on the first call.
-  if (not node)
+  // (Re)create the node on the first call, after leaving indexed mode
+  // or if the size of the model has changed.
+  if (not node or node->width() != model_->width() or node->height() != model_->height())
   {
-    node = new QSGSimpleTextureNode{};
-    node->setRect(boundingRect());
+    delete old;
+    node = new TiledTextureNode{
+        window(),
+        model_->width(),
+        model_->height(),
+        TiledNode::defaultTileSize()
+      };
+    dirty_ = {};  // New tiles are uploaded in full.
+  }
 
-    // Create an empty texture whose size is that of the model.
-    auto texture = window()->createTextureFromImage(
-        QPixmap(model_->width(), model_->height()).toImage()
-      );
-    texture->bind();
-
-    // The magnification filter will be used to magnify each texel
-    // (cell). When doing so, we don't want sharp edges, so we're using
-    // GL_NEAREST instead of GL_LINEAR.
-    openGL->glTexParameteri(
-        GL_TEXTURE_2D,
-        GL_TEXTURE_MAG_FILTER,
-        GL_NEAREST
-      );
+  node->setRect(boundingRect());
+  node->setOrigin(origin());
+  node->setSource(source());
+  node->update(visibleRect(), dirty_);
+  dirty_ = {};
+  return node;
+}
+
+QSGNode*
+View::updateIndexedNode(QSGNode* old)
+{
+  auto node = dynamic_cast<TiledIndexedNode*>(old);
 
-    node->setTexture(texture);
+  // (Re)create the node on the first call, after entering indexed mode
+  // or if the size of the model has changed.
+  if (not node or node->width() != model_->width() or node->height() != model_->height())
+  {
+    delete old;
+    node = new TiledIndexedNode{
+        model_->width(),
+        model_->height(),
+        TiledNode::defaultTileSize()
+      };
+    dirty_ = {};
+    palette_dirty_ = true;
   }
 
-  // Update the texture.
-  auto texture = node->texture();
-  texture->bind();
-  openGL->glTexSubImage2D(
-      GL_TEXTURE_2D,
-      0, 0, 0,
-      model_->width(), model_->height(),
-      GL_BGRA,
-      GL_UNSIGNED_INT_8_8_8_8_REV,  // REV to convert Qt's ARGB to BGRA.
-      pixels_.data()
-    );  // Note: We're using TexSubImage2D instead of TexImage2D, as the
-        // former updates the texture while the latter recreates it.
-  node->markDirty(QSGNode::DirtyGeometry);
+  if (palette_dirty_)
+  {
+    node->setPalette(palette_);
+    palette_dirty_ = false;
+  }
 
-  DRPROF_STOP("View::updatePaintNode");
+  node->setRect(boundingRect());
+  node->setOrigin(origin());
+  node->setSource(model_->indices().data());
+  node->update(visibleRect(), dirty_);
+  dirty_ = {};
   return node;
 }
 
+QRect
+View::visibleRect() const
+{
+  // The part of the item inside the window, in item coordinates.
+  auto visible = mapRectFromScene(QRectF{QPointF{0, 0}, window()->size()}) & boundingRect();
+  if (visible.isEmpty())
+  {
+    return {};
+  }
+
+  // Convert to pixels of the model.
+  qreal scale_x = model_->width() / width();
+  qreal scale_y = model_->height() / height();
+  int left = static_cast<int>(std::floor(visible.left() * scale_x));
+  int top = static_cast<int>(std::floor(visible.top() * scale_y));
+  int right = static_cast<int>(std::ceil(visible.right() * scale_x));
+  int bottom = static_cast<int>(std::ceil(visible.bottom() * scale_y));
+  return QRect{left, top, right - left, bottom - top} & QRect{0, 0, model_->width(), model_->height()};
+}
+
 void
 View::start()
 {
+  completed_ = 0;
+  window_start_ = clock_.nsecsElapsed();
   timer_.start();
 }
 
@@ -109,6 +156,7 @@ void
 View::stop()
 {
   timer_.stop();
+  setGenerationsPerSecond(0.0);
 }
 
 void
@@ -116,11 +164,11 @@ View::toggle()
 {
   if (timer_.isActive())
   {
-    timer_.stop();
+    stop();
   }
   else
   {
-    timer_.start();
+    start();
   }
 }
 
@@ -129,7 +177,140 @@ View::showNextGeneration()
 {
   assert(model_);
   emit updateModel();
-  gate_.ready();  // Inform gate to let this update pass.
+  advance(1);
+}
+
+bool
+View::maxSpeed() const
+{
+  return max_speed_;
+}
+
+double
+View::targetGenerationsPerSecond() const
+{
+  return target_gps_;
+}
+
+double
+View::generationsPerSecond() const
+{
+  return gps_;
+}
+
+qulonglong
+View::population() const
+{
+  return statistics_ and model_ ? model_->statistics().population() : 0;
+}
+
+qulonglong
+View::changedCells() const
+{
+  return statistics_ and model_ ? model_->statistics().changed : 0;
+}
+
+qulonglong
+View::stateCount(int state) const
+{
+  if (not statistics_ or not model_ or state < 0 or state > 255)
+  {
+    return 0;
+  }
+  return model_->statistics().histogram[state];
+}
+
+void
+View::setStatisticsEnabled(bool enabled)
+{
+  statistics_ = enabled;
+  if (model_)
+  {
+    model_->setStatisticsEnabled(enabled);
+  }
+  emit statisticsChanged();
+}
+
+void
+View::setMaxSpeed(bool max_speed)
+{
+  if (max_speed == max_speed_)
+  {
+    return;
+  }
+
+  max_speed_ = max_speed;
+  batch_ = 1;
+  setTargetGenerationsPerSecond(1000.0 / std::max(timer_.interval(), 1));
+  emit maxSpeedChanged();
+}
+
+void
+View::setFrameBudget(int ms)
+{
+  budget_ = static_cast<qint64>(std::max(ms, 1)) * 1000000;
+}
+
+void
+View::advance(int generations)
+{
+  // A threaded model coalesces requests, so the generations requested
+  // while another request is pending may not be computed at all.
+  if (not model_ or pending_ > 0)
+  {
+    return;
+  }
+
+  pending_ = generations;
+  requested_at_ = clock_.nsecsElapsed();
+  model_->advance(generations);
+}
+
+void
+View::measure()
+{
+  // Weight of the latest measurement.
+  constexpr double smoothing = 0.25;
+
+  auto now = clock_.nsecsElapsed();
+  double cost = static_cast<double>(now - requested_at_) / pending_;
+  cost_ = cost_ > 0.0 ? cost_ + smoothing * (cost - cost_) : cost;
+  completed_ += pending_;
+  pending_ = 0;
+
+  if (max_speed_)
+  {
+    auto fit = static_cast<double>(budget_) / std::max(cost_, 1.0);
+    batch_ = static_cast<int>(std::clamp(fit, 1.0, 2.0 * batch_));
+  }
+  setTargetGenerationsPerSecond(batch_ * 1000.0 / std::max(timer_.interval(), 1));
+
+  if (now - window_start_ >= 1000000000)
+  {
+    setGenerationsPerSecond(completed_ * 1e9 / (now - window_start_));
+    completed_ = 0;
+    window_start_ = now;
+  }
+}
+
+void
+View::setTargetGenerationsPerSecond(double gps)
+{
+  if (gps != target_gps_)
+  {
+    target_gps_ = gps;
+    emit targetGenerationsPerSecondChanged();
+  }
+}
+
+void
+View::setGenerationsPerSecond(double gps)
+{
+  if (gps != gps_)
+  {
+    gps_ = gps;
+    emit generationsPerSecondChanged();
+  }
 }
 
 void
@@ -164,6 +345,33 @@ View::onClicked(qreal x, qreal y)
   model_->increment(xcell, ycell);
 }
 
+void
+View::onDragged(qreal x, qreal y)
+{
+  assert(model_);
+
+  if (xcell_ == -1 or x >= width() or x < 0 or y >= height() or y < 0)
+  {
+    onClicked(x, y);
+    return;
+  }
+
+  int xcell = model_->width()  * static_cast<float>(x / width());
+  int ycell = model_->height() * static_cast<float>(y / height());
+  if (xcell == xcell_ and ycell == ycell_)
+  {
+    return;
+  }
+
+  // The previous cell was already incremented.
+  auto cells = detail::line({xcell_, ycell_}, {xcell, ycell});
+  cells.erase(cells.begin());
+  xcell_ = xcell;
+  ycell_ = ycell;
+
+  model_->incrementCells(cells);
+}
+
 void
 View::onWindowChanged(QQuickWindow* window)
 {
@@ -190,48 +398,155 @@ View::updatePixels()
     return;
   }
 
-  // Compute vertex colors.
-  std::transform(
-      model_->vertices().begin(),
-      model_->vertices().end(),
-      pixels_.begin(),
-      [&](int x) { return coloring_[x]; }
-    );
+  if (pending_ > 0)
+  {
+    measure();
+  }
+
+  // Even if nothing has changed, a frame must be rendered, so that the
+  // gate lets the next update pass.
+  auto rect = model_->dirty();
+  if (not rect.isEmpty())
+  {
+    if (useOwnPixels())
+    {
+      colorize(rect);
+    }
+    for (const auto& part : TiledNode::wrap(rect, origin(), {model_->width(), model_->height()}))
+    {
+      dirty_ += part;
+    }
+  }
+  if (statistics_)
+  {
+    emit statisticsChanged();
+  }
+  update();
+}
 
-  // Load pixels.
+void
+View::onViewportChanged()
+{
+  // The textures are resized by `updatePaintNode`.
+  QRect rect{0, 0, model_->width(), model_->height()};
+  pixels_.resize(useOwnPixels() ? model_->width() * model_->height() : 0);
+  if (useOwnPixels())
+  {
+    colorize(rect);
+  }
+  dirty_ = rect;
   update();
 }
 
+void
+View::colorize(const QRect& rect)
+{
+  DRPROF_START("View::colorize");
+  const auto& vertices = model_->vertices();
+  int width = model_->width();
+  auto colorizeRows = [&] (int top, int bottom) {
+      for (int y = top; y < bottom; ++y)
+      {
+        auto first = y * width + rect.left();
+        detail::colorize(vertices.data() + first, rect.width(), palette_, pixels_.data() + first);
+      }
+    };
+
+  // Below this number of pixels, waking up the workers costs more than
+  // it saves.
+  constexpr int parallel_threshold = 1 << 16;
+  if (rect.width() * rect.height() < parallel_threshold)
+  {
+    colorizeRows(rect.top(), rect.bottom() + 1);
+  }
+  else
+  {
+    if (not pool_)
+    {
+      pool_ = std::make_unique<ThreadPool>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    int num_threads = static_cast<int>(pool_->size());
+    pool_->run([&] (std::size_t i) {
+        int top = rect.top() + rect.height() * static_cast<int>(i) / num_threads;
+        int bottom = rect.top() + rect.height() * static_cast<int>(i + 1) / num_threads;
+        colorizeRows(top, bottom);
+      });
+  }
+  DRPROF_STOP("View::colorize");
+}
+
+bool
+View::useIndices() const
+{
+  return indexed_ and not model_->indices().empty();
+}
+
+bool
+View::useOwnPixels() const
+{
+  return not useIndices() and model_->pixels().empty();
+}
+
+const Color*
+View::source() const
+{
+  const auto& pixels = model_->pixels();
+  return pixels.empty() ? pixels_.data() : pixels.data();
+}
+
+QPoint
+View::origin() const
+{
+  // The view colorizes the vertices, which aren't wrap-addressed.
+  if (useOwnPixels())
+  {
+    return {};
+  }
+  return model_->origin();
+}
+
 void
 View::setModel(std::shared_ptr<IModel> model)
 {
   // Disconnect previous model.
   if (model_)
   {
-    QObject::disconnect(
-        &gate_, &Gate::ready,
-        model_.get(), &IModel::doUpdate
-      );
     QObject::disconnect(
         model_.get(), &IModel::updated,
         this, &View::updatePixels
       );
+    QObject::disconnect(
+        model_.get(), &IModel::viewportChanged,
+        this, &View::onViewportChanged
+      );
   }
 
   // Save and connect the new model.
   model_ = std::move(model);
-  QObject::connect(
-      &gate_, &Gate::ready,
-      model_.get(), &IModel::doUpdate
-    );
+  pending_ = 0;
   QObject::connect(
       model_.get(), &IModel::updated,
       this, &View::updatePixels
     );
+  QObject::connect(
+      model_.get(), &IModel::viewportChanged,
+      this, &View::onViewportChanged
+    );
 
-  // Resize the pixel array accordingly, and update the pixel array.
-  pixels_.resize(model_->width() * model_->height());
-  // updatePixels();
+  // Resize the pixel array accordingly (unless the model colorizes the
+  // cells itself), and pass on the palette and mode.
+  if (indexed_)
+  {
+    model_->setIndexed(true);
+  }
+  if (statistics_)
+  {
+    model_->setStatisticsEnabled(true);
+  }
+  pixels_.resize(useOwnPixels() ? model_->width() * model_->height() : 0);
+  dirty_ = QRect{0, 0, model_->width(), model_->height()};
+  palette_dirty_ = true;
+  model_->setPalette(palette_);
 }
 
 void
@@ -239,13 +554,60 @@ View::setFramerate(int fps)
 {
   int frame_duration = std::floor(1000.0f / fps);
   timer_.setInterval(frame_duration);
+  setTargetGenerationsPerSecond(batch_ * 1000.0 / std::max(frame_duration, 1));
 }
 
 void
 View::setColor(int vertex, int r, int g, int b)
 {
-  coloring_[vertex] = qRgb(r, g, b);
-  updatePixels();
+  palette_.setColor(vertex, qRgb(r, g, b));
+  updatePalette();
+}
+
+void
+View::setFallbackColor(int r, int g, int b)
+{
+  palette_.setFallback(qRgb(r, g, b));
+  updatePalette();
+}
+
+void
+View::updatePalette()
+{
+  if (not model_)
+  {
+    return;
+  }
+
+  // The model emits `updated` if it colorizes the cells itself.
+  palette_dirty_ = true;
+  model_->setPalette(palette_);
+  if (useOwnPixels())
+  {
+    colorize({0, 0, model_->width(), model_->height()});
+    dirty_ = QRect{0, 0, model_->width(), model_->height()};
+  }
+  update();
+}
+
+void
+View::setIndexed(bool indexed)
+{
+  indexed_ = indexed;
+  if (not model_)
+  {
+    return;
+  }
+
+  // The model emits `updated`, which schedules the upload.
+  model_->setIndexed(indexed_);
+  pixels_.resize(useOwnPixels() ? model_->width() * model_->height() : 0);
+  if (useOwnPixels())
+  {
+    colorize({0, 0, model_->width(), model_->height()});
+  }
+  dirty_ = QRect{0, 0, model_->width(), model_->height()};
+  update();
 }
 
 void
@@ -21,13 +21,17 @@
 
 #include <memory>
 
+#include <QElapsedTimer>
 #include <QQuickItem>
 #include <QQuickWindow>
+#include <QRegion>
 #include <QTimer>
 
 #include "detail/Gate.h"
+#include "detail/ThreadPool.h"
 #include "Color.h"
 #include "IModel.h"
+#include "Palette.h"
 
 /* View
 
@@ -40,12 +44,32 @@ model's vertex container must be mapped to a color. The
 { vertex -> color }
 
 mapping may be configured using `setColor`. Unconfigured vertices will
-appear solid black.
+appear in the fallback color (solid black unless configured using
+`setFallbackColor`). The mapping is passed on to the model, which
+colorizes the cells (see `IModel::pixels`).
+
+Using `setIndexed`, the view may be switched to _indexed mode_, in which
+the model's palette indices are uploaded instead of colors (see
+`IModel::indices`), and the palette is applied on the GPU. This cuts the
+upload bandwidth by a factor of four. Vertices larger than 254 are
+displayed in the fallback color.
 
 Using `setFramerate`, the frequency with which the model is updated may
 be specified in Hz. This update tick can be started and stopped using
 the `start`, `stop` and `toggle` methods.
 
+By default, one generation is computed per tick. In _max speed mode_
+(see `setMaxSpeed`), the view measures the cost of a generation and
+computes as many generations per tick as fit into the frame budget (see
+`setFrameBudget`). The planned and the measured number of generations
+per second are available as the `targetGenerationsPerSecond` and
+`generationsPerSecond` properties.
+
+Using `setStatisticsEnabled`, the CA may be asked to count its states
+while computing each generation. The counts of the generation shown are
+available as the `population` and `changedCells` properties and through
+`stateCount`; `statisticsChanged` is emitted with every update.
+
 *** Implementation details ***
 
 * `timer_` handles the framerate, start/stop/toggle methods.
@@ -54,11 +78,42 @@ the `start`, `stop` and `toggle` methods.
 
   (1) When `timer_` has timed out and `window()` has rendered the
       previous frame (indicated by the `frameSwapped()` signal), call
-      `updateModel()`.
-
-  (2) When `IModel::updated()` is received, run `updatePixels()` to update
-      the `pixels_` array. Then run `update()` to transfer the `pixels_`
-      array to the texture.
+      `IModel::advance(batch_)`.
+
+  (2) When `IModel::updated()` is received, run `updatePixels()`. Then
+      run `update()` to transfer the model's pixels to the texture.
+
+* The scene graph node is a `TiledIndexedNode` in indexed mode,
+  otherwise a `TiledTextureNode`, so that models larger than the
+  maximum texture size can be displayed. The palette textures of the
+  former are only updated if `palette_dirty_` is set.
+
+* Only the tiles which intersect the part of the view that is visible
+  in the window are kept on the GPU. Since this is checked in
+  `updatePaintNode`, tiles are paged in and out when the view is
+  updated, not immediately when the view is moved.
+
+* If the model doesn't provide pixels, the view colorizes the vertices
+  into `pixels_` itself. Large rectangles are split into bands of rows
+  which are colorized by the workers of `pool_`, which is created on
+  first use.
+
+* The time between calling `IModel::advance` and receiving
+  `IModel::updated` is divided by the number of generations requested
+  (`pending_`), and the result is smoothed into `cost_`. No further
+  generations are requested until the model has delivered them. In max
+  speed mode, `batch_` is set to the number of generations that fit
+  into `budget_` at that cost, but may at most double from one tick to
+  the next. The achieved rate is computed from the generations
+  completed during (roughly) the last second.
+
+* The rectangles of pixels changed since the last upload (see
+  `IModel::dirty()`) are collected in `dirty_`, and only this region is
+  transferred to the tiles. As the model's pixels are wrap-addressed,
+  the rectangles are converted to positions in the pixel container
+  using `IModel::origin()` when they are received, so that a pan of the
+  model in the meantime doesn't misplace them. The origin itself is
+  applied by the tiled node's geometry when the frame is rendered.
 */
 
 namespace drautomaton {
@@ -66,21 +121,56 @@ namespace drautomaton {
 class View : public QQuickItem
 {
   Q_OBJECT
+  Q_PROPERTY(bool maxSpeed READ maxSpeed WRITE setMaxSpeed NOTIFY maxSpeedChanged)
+  Q_PROPERTY(double targetGenerationsPerSecond READ targetGenerationsPerSecond NOTIFY targetGenerationsPerSecondChanged)
+  Q_PROPERTY(double generationsPerSecond READ generationsPerSecond NOTIFY generationsPerSecondChanged)
+  Q_PROPERTY(qulonglong population READ population NOTIFY statisticsChanged)
+  Q_PROPERTY(qulonglong changedCells READ changedCells NOTIFY statisticsChanged)
 
 public:
   View();
 
+  bool maxSpeed() const;
+  double targetGenerationsPerSecond() const;
+  double generationsPerSecond() const;
+
+  // Return the population and the number of changed cells of the
+  // generation shown, or 0 if statistics are disabled.
+  qulonglong population() const;
+  qulonglong changedCells() const;
+
 public slots:
   void setModel(std::shared_ptr<IModel>);
 
   // Set framerate in Hz.
   Q_INVOKABLE void setFramerate(int fps);
 
+  // Enable or disable max speed mode.
+  Q_INVOKABLE void setMaxSpeed(bool);
+
+  // Set the time (in ms) per frame which may be spent computing
+  // generations in max speed mode. Default is 10ms.
+  Q_INVOKABLE void setFrameBudget(int ms);
+
   // Set the color of `vertex` in terms of RGB values or as `QColor`.
   // The `r`, `g`, `b` values must lie in [0, 256).
   Q_INVOKABLE void setColor(int vertex, int r, int g, int b);
   void setColor(int, QColor);
 
+  // Set the color of unconfigured vertices.
+  Q_INVOKABLE void setFallbackColor(int r, int g, int b);
+
+  // Enable or disable indexed mode. If the model doesn't support
+  // indexed mode, this has no effect.
+  Q_INVOKABLE void setIndexed(bool);
+
+  // Enable or disable statistics (see `IModel::setStatisticsEnabled`).
+  Q_INVOKABLE void setStatisticsEnabled(bool);
+
+  // Return the number of cells in state `state` (in `[0, 255]`) of the
+  // generation shown, or 0 if statistics are disabled.
+  Q_INVOKABLE qulonglong stateCount(int state) const;
+
   // Start, stop and toggle on/off.
   Q_INVOKABLE void start();
   Q_INVOKABLE void stop();
@@ -93,6 +183,12 @@ public slots:
   // with the cell coords as parameters.
   Q_INVOKABLE void onClicked(qreal, qreal);
 
+  // Handle a move of the mouse while the button is held down: Like
+  // `onClicked`, but increment all cells on the line from the
+  // previously handled cell to the current one as a single batch (see
+  // `IModel::incrementCells`), so that fast strokes aren't broken up.
+  Q_INVOKABLE void onDragged(qreal, qreal);
+
   // Compute the next generation of cells, even if the CA/view is
   // stopped.
   Q_INVOKABLE void showNextGeneration();
@@ -104,23 +200,88 @@ private slots:
   // Grab `QQuickWindow::frameSwapped` from new window.
   void onWindowChanged(QQuickWindow*);
 
-  // Update the private pixel vector. Asserts that if `model_` is not
-  // null, then `pixels_` has size (at least)
+  // Schedule the upload of the pixels in the model's dirty rectangle.
+  // Asserts that if `model_` is not null and doesn't provide pixels,
+  // then `pixels_` has size (at least)
   // `model_->width() * model_->height()`.
   void updatePixels();
 
+  // Resize the pixels and textures to the new dimensions of the model.
+  void onViewportChanged();
+
 signals:
   // Emit to update the model.
   void updateModel();
 
+  void maxSpeedChanged();
+  void targetGenerationsPerSecondChanged();
+  void generationsPerSecondChanged();
+  void statisticsChanged();
+
 private:
+  // Create or update the scene graph node.
+  QSGNode* updateTextureNode(QSGNode*);
+  QSGNode* updateIndexedNode(QSGNode*);
+
+  // Return the rectangle of the model's pixels which is visible in the
+  // window.
+  QRect visibleRect() const;
+
+  // Check if the model provides indices which are used for display, or
+  // if the view colorizes the vertices itself.
+  bool useIndices() const;
+  bool useOwnPixels() const;
+
+  // Colorize the vertices in `rect` into `pixels_`.
+  void colorize(const QRect& rect);
+
+  // Request `generations` generations from the model.
+  void advance(int generations);
+
+  // Update the cost estimate, batch size and rates after the model has
+  // computed the pending generations.
+  void measure();
+
+  // Set the generations-per-second properties, and emit the respective
+  // signals if they have changed.
+  void setTargetGenerationsPerSecond(double);
+  void setGenerationsPerSecond(double);
+
+  // Pass the palette on to the model and recolor all pixels.
+  void updatePalette();
+
+  // Return the pixels to upload.
+  const Color* source() const;
+
+  // Return the position of the top-left pixel in `source()` (or the
+  // model's indices).
+  QPoint origin() const;
+
   // Control flow.
   QTimer timer_;
   Gate gate_;
 
+  // Stepping.
+  QElapsedTimer clock_{};
+  bool max_speed_ = false;
+  qint64 budget_ = 10000000;  // In ns.
+  int batch_ = 1;  // Generations per tick.
+  int pending_ = 0;  // Generations requested, but not yet computed.
+  qint64 requested_at_ = 0;
+  double cost_ = 0.0;  // Estimated cost of a generation in ns.
+  int completed_ = 0;  // Generations computed since `window_start_`.
+  qint64 window_start_ = 0;
+  double target_gps_ = 0.0;
+  double gps_ = 0.0;
+
   // Data.
-  std::map<int, Color> coloring_;
-  std::vector<Color> pixels_{};
+  Palette palette_{};
+  bool palette_dirty_ = true;  // Palette not yet uploaded to the GPU.
+  bool indexed_ = false;
+  bool statistics_ = false;
+  std::vector<Color> pixels_{};  // Only used if the model has no pixels.
+  std::unique_ptr<ThreadPool> pool_{};
+  QRegion dirty_{};  // Pixels not yet uploaded to the texture.
   std::shared_ptr<IModel> model_{};
 
   // Coordinates of the previously hovered cell. Equal to -1 if mouse is
@@ -0,0 +1,86 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Colorize.h"
+
+#include <algorithm>
+
+#if defined(__GNUC__) and (defined(__x86_64__) or defined(__i386__))
+#define DRAUTOMATON_COLORIZE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace drautomaton { namespace detail {
+
+namespace {
+
+void
+colorizeScalar(const int* vertices, std::size_t count, const Color* table, unsigned int size, Color* pixels)
+{
+  // Branch-free clamp into the lookup table (see `Palette`).
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    pixels[i] = table[std::min(static_cast<unsigned int>(vertices[i]), size)];
+  }
+}
+
+#ifdef DRAUTOMATON_COLORIZE_AVX2
+// Compiled for AVX2 regardless of the compiler flags; only called if
+// the CPU supports it.
+__attribute__((target("avx2")))
+void
+colorizeAvx2(const int* vertices, std::size_t count, const Color* table, unsigned int size, Color* pixels)
+{
+  auto max = _mm256_set1_epi32(static_cast<int>(size));
+  auto base = reinterpret_cast<const int*>(table);
+  std::size_t i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vertices + i));
+    v = _mm256_min_epu32(v, max);
+    auto colors = _mm256_i32gather_epi32(base, v, 4);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pixels + i), colors);
+  }
+  colorizeScalar(vertices + i, count - i, table, size, pixels + i);
+}
+
+bool
+hasAvx2()
+{
+  static const bool result = __builtin_cpu_supports("avx2");
+  return result;
+}
+#endif
+
+} // namespace
+
+void
+colorize(const int* vertices, std::size_t count, const Palette& palette, Color* pixels)
+{
+  auto size = static_cast<unsigned int>(palette.size());
+#ifdef DRAUTOMATON_COLORIZE_AVX2
+  if (hasAvx2())
+  {
+    colorizeAvx2(vertices, count, palette.table(), size, pixels);
+    return;
+  }
+#endif
+  colorizeScalar(vertices, count, palette.table(), size, pixels);
+}
+
+}} // namespace drautomaton::detail
@@ -0,0 +1,35 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_COLORIZE_H
+#define DRAUTOMATON_SRC_DETAIL_COLORIZE_H
+
+#include <cstddef>
+
+#include "Color.h"
+#include "Palette.h"
+
+namespace drautomaton { namespace detail {
+
+// Set `pixels[i]` to `palette.color(vertices[i])` for every `i` in
+// `[0, count)`. Uses AVX2 gathers if the CPU supports them.
+void colorize(const int* vertices, std::size_t count, const Palette& palette, Color* pixels);
+
+}} // namespace drautomaton::detail
+
+#endif /* DRAUTOMATON_SRC_DETAIL_COLORIZE_H */
@@ -0,0 +1,105 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_COUNTALLOCATIONS_H
+#define DRAUTOMATON_SRC_DETAIL_COUNTALLOCATIONS_H
+
+#include <new>
+
+#include "Profiling.h"
+
+/* CountAllocations
+
+Replacements of the global `operator new`/`operator delete` which record
+every allocation using `drprof::allocate`.
+
+Include this header in exactly _one_ source file of an executable (not
+of a library) to enable allocation counting for the whole process.
+*/
+
+void*
+operator new(std::size_t size)
+{
+  if (auto ptr = drprof::allocate(size))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void*
+operator new[](std::size_t size)
+{
+  return ::operator new(size);
+}
+
+void*
+operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  return drprof::allocate(size);
+}
+
+void*
+operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return drprof::allocate(size);
+}
+
+void*
+operator new(std::size_t size, std::align_val_t alignment)
+{
+  if (auto ptr = drprof::allocateAligned(size, static_cast<std::size_t>(alignment)))
+  {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void*
+operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return ::operator new(size, alignment);
+}
+
+void*
+operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return drprof::allocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void*
+operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return drprof::allocateAligned(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* ptr) noexcept { drprof::deallocate(ptr); }
+void operator delete[](void* ptr) noexcept { drprof::deallocate(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { drprof::deallocate(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { drprof::deallocate(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { drprof::deallocate(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { drprof::deallocate(ptr); }
+
+void operator delete(void* ptr, std::align_val_t) noexcept { drprof::deallocateAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { drprof::deallocateAligned(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { drprof::deallocateAligned(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { drprof::deallocateAligned(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { drprof::deallocateAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { drprof::deallocateAligned(ptr); }
+
+#endif /* DRAUTOMATON_SRC_DETAIL_COUNTALLOCATIONS_H */
@@ -0,0 +1,268 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "IndexedNode.h"
+
+#include <array>
+
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+
+namespace drautomaton {
+
+namespace {
+
+class IndexedShader : public QSGMaterialShader
+{
+public:
+  const char*
+  vertexShader() const override
+  {
+    return
+        "attribute highp vec4 qt_VertexPosition;\n"
+        "attribute highp vec2 qt_VertexTexCoord;\n"
+        "uniform highp mat4 qt_Matrix;\n"
+        "varying highp vec2 coord;\n"
+        "void main()\n"
+        "{\n"
+        "  coord = qt_VertexTexCoord;\n"
+        "  gl_Position = qt_Matrix * qt_VertexPosition;\n"
+        "}\n";
+  }
+
+  // The index is stored in the red channel, normalized to [0, 1]. Look
+  // up the center of the corresponding texel of the palette.
+  const char*
+  fragmentShader() const override
+  {
+    return
+        "uniform sampler2D indices;\n"
+        "uniform sampler2D palette;\n"
+        "uniform lowp float qt_Opacity;\n"
+        "varying highp vec2 coord;\n"
+        "void main()\n"
+        "{\n"
+        "  highp float index = texture2D(indices, coord).r * 255.0;\n"
+        "  gl_FragColor = texture2D(palette, vec2((index + 0.5) / 256.0, 0.5)) * qt_Opacity;\n"
+        "}\n";
+  }
+
+  char const* const*
+  attributeNames() const override
+  {
+    static const char* const names[] = {"qt_VertexPosition", "qt_VertexTexCoord", nullptr};
+    return names;
+  }
+
+  void
+  updateState(const RenderState& state, QSGMaterial* new_material, QSGMaterial*) override
+  {
+    if (state.isMatrixDirty())
+    {
+      program()->setUniformValue(matrix_id_, state.combinedMatrix());
+    }
+    if (state.isOpacityDirty())
+    {
+      program()->setUniformValue(opacity_id_, state.opacity());
+    }
+    program()->setUniformValue(indices_id_, 0);
+    program()->setUniformValue(palette_id_, 1);
+
+    auto material = static_cast<IndexedMaterial*>(new_material);
+    auto openGL = QOpenGLContext::currentContext()->functions();
+    openGL->glActiveTexture(GL_TEXTURE1);
+    openGL->glBindTexture(GL_TEXTURE_2D, material->paletteTexture());
+    openGL->glActiveTexture(GL_TEXTURE0);
+    openGL->glBindTexture(GL_TEXTURE_2D, material->indexTexture());
+  }
+
+protected:
+  void
+  initialize() override
+  {
+    matrix_id_ = program()->uniformLocation("qt_Matrix");
+    opacity_id_ = program()->uniformLocation("qt_Opacity");
+    indices_id_ = program()->uniformLocation("indices");
+    palette_id_ = program()->uniformLocation("palette");
+  }
+
+private:
+  int matrix_id_ = -1;
+  int opacity_id_ = -1;
+  int indices_id_ = -1;
+  int palette_id_ = -1;
+};
+
+// Create a texture with nearest-neighbor filtering (so that cells have
+// sharp edges) and no mipmaps or wrapping (which NPOT textures don't
+// support on OpenGL ES 2).
+GLuint
+createTexture(QOpenGLFunctions* openGL)
+{
+  GLuint texture = 0;
+  openGL->glGenTextures(1, &texture);
+  openGL->glBindTexture(GL_TEXTURE_2D, texture);
+  openGL->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  openGL->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  openGL->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  openGL->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  return texture;
+}
+
+} // namespace
+
+IndexedMaterial::IndexedMaterial(int width, int height)
+:
+  width_{width},
+  height_{height}
+{
+  auto context = QOpenGLContext::currentContext();
+  auto openGL = context->functions();
+
+  // GL_LUMINANCE was removed from core profiles, GL_R8 was added in
+  // OpenGL 3.0.
+  r8_ = not context->isOpenGLES() and context->format().majorVersion() >= 3;
+
+  indices_ = createTexture(openGL);
+  openGL->glTexImage2D(
+      GL_TEXTURE_2D, 0,
+      r8_ ? GL_R8 : GL_LUMINANCE,
+      width_, height_, 0,
+      r8_ ? GL_RED : GL_LUMINANCE,
+      GL_UNSIGNED_BYTE,
+      nullptr
+    );
+
+  palette_ = createTexture(openGL);
+  openGL->glTexImage2D(
+      GL_TEXTURE_2D, 0, GL_RGBA, 256, 1, 0,
+      GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,  // REV to convert Qt's ARGB to BGRA.
+      nullptr
+    );
+}
+
+IndexedMaterial::~IndexedMaterial()
+{
+  auto openGL = QOpenGLContext::currentContext()->functions();
+  openGL->glDeleteTextures(1, &indices_);
+  openGL->glDeleteTextures(1, &palette_);
+}
+
+QSGMaterialType*
+IndexedMaterial::type() const
+{
+  static QSGMaterialType type{};
+  return &type;
+}
+
+QSGMaterialShader*
+IndexedMaterial::createShader() const
+{
+  return new IndexedShader{};
+}
+
+int
+IndexedMaterial::compare(const QSGMaterial* other) const
+{
+  auto material = static_cast<const IndexedMaterial*>(other);
+  if (indices_ != material->indices_)
+  {
+    return indices_ < material->indices_ ? -1 : 1;
+  }
+  return 0;
+}
+
+int
+IndexedMaterial::width() const
+{
+  return width_;
+}
+
+int
+IndexedMaterial::height() const
+{
+  return height_;
+}
+
+void
+IndexedMaterial::uploadIndices(
+    const QRect& rect,
+    const std::uint8_t* indices,
+    int width,
+    const QPoint& origin
+  )
+{
+  auto openGL = QOpenGLContext::currentContext()->functions();
+  openGL->glBindTexture(GL_TEXTURE_2D, indices_);
+  uploader_.upload(rect, indices, width, 1, r8_ ? GL_RED : GL_LUMINANCE, GL_UNSIGNED_BYTE, origin);
+}
+
+void
+IndexedMaterial::uploadPalette(const Palette& palette)
+{
+  std::array<Color, 256> colors{};
+  for (int i = 0; i < 255; ++i)
+  {
+    colors[i] = palette.color(i);
+  }
+  colors[255] = palette.fallback();
+
+  auto openGL = QOpenGLContext::currentContext()->functions();
+  openGL->glBindTexture(GL_TEXTURE_2D, palette_);
+  openGL->glTexSubImage2D(
+      GL_TEXTURE_2D, 0, 0, 0, 256, 1,
+      GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV,
+      colors.data()
+    );
+}
+
+GLuint
+IndexedMaterial::indexTexture() const
+{
+  return indices_;
+}
+
+GLuint
+IndexedMaterial::paletteTexture() const
+{
+  return palette_;
+}
+
+IndexedNode::IndexedNode(int width, int height)
+{
+  // The scene graph may access the geometry and the material while the
+  // node is destroyed, so we let the base class delete them.
+  setGeometry(new QSGGeometry{QSGGeometry::defaultAttributes_TexturedPoint2D(), 4});
+  setMaterial(new IndexedMaterial{width, height});
+  setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+}
+
+void
+IndexedNode::setRect(const QRectF& rect)
+{
+  QSGGeometry::updateTexturedRectGeometry(geometry(), rect, QRectF{0, 0, 1, 1});
+  markDirty(QSGNode::DirtyGeometry);
+}
+
+IndexedMaterial*
+IndexedNode::indexedMaterial()
+{
+  return static_cast<IndexedMaterial*>(material());
+}
+
+} // namespace drautomaton
@@ -0,0 +1,102 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_INDEXEDNODE_H
+#define DRAUTOMATON_SRC_DETAIL_INDEXEDNODE_H
+
+#include <cstdint>
+
+#include <QOpenGLFunctions>
+#include <QSGGeometryNode>
+#include <QSGMaterial>
+
+#include "Palette.h"
+#include "TextureUploader.h"
+
+namespace drautomaton {
+
+/* IndexedMaterial
+
+Scene graph material which colorizes a texture of palette indices on the
+GPU.
+
+The material owns two textures: The _index texture_ of the specified
+size holds one byte per texel (GL_R8 if available, GL_LUMINANCE
+otherwise), and the _palette texture_ of size 256x1 holds the colors of
+the indices 0 to 254, followed by the fallback color at index 255.
+
+The ctor and dtor must be called with an OpenGL context current, which
+is the case in `QQuickItem::updatePaintNode` and when the scene graph
+deletes the node.
+*/
+
+class IndexedMaterial : public QSGMaterial
+{
+public:
+  IndexedMaterial(int width, int height);
+  ~IndexedMaterial() override;
+
+  QSGMaterialType* type() const override;
+  QSGMaterialShader* createShader() const override;
+  int compare(const QSGMaterial* other) const override;
+
+  int width() const;
+  int height() const;
+
+  // Upload the rectangle `rect` of the image `indices`, which holds
+  // rows of `width` indices, such that the index `(x, y)` is written
+  // to the texel `(x, y) - origin` (see `TextureUploader::upload`).
+  void uploadIndices(
+      const QRect& rect,
+      const std::uint8_t* indices,
+      int width,
+      const QPoint& origin = {}
+    );
+
+  // Upload the colors of `palette`.
+  void uploadPalette(const Palette& palette);
+
+  GLuint indexTexture() const;
+  GLuint paletteTexture() const;
+
+private:
+  int width_;
+  int height_;
+  bool r8_;
+  GLuint indices_ = 0;
+  GLuint palette_ = 0;
+  TextureUploader uploader_{};
+};
+
+/* IndexedNode
+
+Rectangular scene graph node which displays an `IndexedMaterial`.
+*/
+
+class IndexedNode : public QSGGeometryNode
+{
+public:
+  IndexedNode(int width, int height);
+
+  void setRect(const QRectF& rect);
+  IndexedMaterial* indexedMaterial();
+};
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_DETAIL_INDEXEDNODE_H */
@@ -0,0 +1,199 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace drautomaton {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+{
+  HANDLE file = ::CreateFileA(
+      path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+    );
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    throw std::runtime_error{"could not open " + path};
+  }
+
+  LARGE_INTEGER size{};
+  if (not ::GetFileSizeEx(file, &size))
+  {
+    ::CloseHandle(file);
+    throw std::runtime_error{"could not stat " + path};
+  }
+  size_ = static_cast<std::size_t>(size.QuadPart);
+
+  // Empty files can't be mapped.
+  if (size_ > 0)
+  {
+    HANDLE mapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* data = mapping ? ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (mapping)
+    {
+      // The view keeps the mapping alive.
+      ::CloseHandle(mapping);
+    }
+    if (not data)
+    {
+      ::CloseHandle(file);
+      throw std::runtime_error{"could not map " + path};
+    }
+    data_ = static_cast<const char*>(data);
+  }
+
+  ::CloseHandle(file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+{
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+  {
+    throw std::runtime_error{"could not open " + path};
+  }
+
+  struct stat status{};
+  if (::fstat(fd, &status) == -1)
+  {
+    ::close(fd);
+    throw std::runtime_error{"could not stat " + path};
+  }
+  size_ = static_cast<std::size_t>(status.st_size);
+
+  // Empty files can't be mapped.
+  if (size_ > 0)
+  {
+    void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+    {
+      ::close(fd);
+      throw std::runtime_error{"could not map " + path};
+    }
+    data_ = static_cast<const char*>(data);
+  }
+
+  // The mapping stays valid after closing the file.
+  ::close(fd);
+}
+
+#endif
+
+MappedFile::~MappedFile()
+{
+  unmap();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+:
+  data_{std::exchange(other.data_, nullptr)},
+  size_{std::exchange(other.size_, 0)}
+{}
+
+MappedFile&
+MappedFile::operator=(MappedFile&& other) noexcept
+{
+  if (this != &other)
+  {
+    unmap();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+  }
+  return *this;
+}
+
+const char*
+MappedFile::data() const
+{
+  return data_;
+}
+
+std::size_t
+MappedFile::size() const
+{
+  return size_;
+}
+
+#ifdef _WIN32
+
+void
+MappedFile::prefetch(std::size_t, std::size_t) const
+{}
+
+void
+MappedFile::unmap()
+{
+  if (data_)
+  {
+    ::UnmapViewOfFile(data_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+#else
+
+void
+MappedFile::prefetch(std::size_t offset, std::size_t length) const
+{
+  if (offset >= size_)
+  {
+    return;
+  }
+  length = std::min(length, size_ - offset);
+
+  // The address must be aligned to a page.
+  auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  auto begin = offset - offset % page;
+  ::posix_madvise(const_cast<char*>(data_ + begin), length + (offset - begin), POSIX_MADV_WILLNEED);
+}
+
+void
+MappedFile::unmap()
+{
+  if (data_)
+  {
+    ::munmap(const_cast<char*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+#endif
+
+} // namespace drautomaton
@@ -0,0 +1,64 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_MAPPEDFILE_H
+#define DRAUTOMATON_SRC_DETAIL_MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace drautomaton {
+
+/* MappedFile
+
+Read-only memory mapping of a whole file. The mapping is private, so
+changes made to the file by other processes while it is mapped may or
+may not be visible.
+
+The ctor throws if the file can't be opened or mapped.
+*/
+
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  MappedFile(MappedFile&&) noexcept;
+  MappedFile& operator=(MappedFile&&) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const;
+  std::size_t size() const;
+
+  // Advise the kernel to read `[offset, offset + length)` ahead of
+  // access. The range is clamped to the file; errors are ignored. Does
+  // nothing on Windows.
+  void prefetch(std::size_t offset, std::size_t length) const;
+
+private:
+  void unmap();
+
+  const char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_DETAIL_MAPPEDFILE_H */
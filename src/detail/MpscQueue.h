@@ -0,0 +1,129 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_MPSCQUEUE_H
+#define DRAUTOMATON_SRC_DETAIL_MPSCQUEUE_H
+
+#include <atomic>
+#include <utility>
+
+namespace drautomaton {
+
+/* MpscQueue
+
+Unbounded lock-free multi-producer/single-consumer FIFO queue of values
+of type `T`. Any number of threads may `push` concurrently; a single
+consumer thread calls `pop` and `empty`. Producers never wait for each
+other or for the consumer.
+
+*** Implementation details ***
+
+* Dmitry Vyukov's non-intrusive MPSC queue: Every value lives in a
+  heap-allocated node. Producers swap their node into `head_` and then
+  link it to its predecessor. The consumer owns `tail_`, a dummy node
+  whose successor holds the oldest value.
+
+* Between the swap and the link, the nodes after the predecessor are
+  invisible to the consumer, so `pop` may briefly report an empty queue
+  while a `push` is in progress. The value is seen by the next `pop`.
+
+* `T` must be default constructible (for the dummy node).
+*/
+
+template<typename T>
+class MpscQueue
+{
+public:
+  MpscQueue();
+  ~MpscQueue();
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  // Producers.
+  void push(T value);
+
+  // Consumer. Return `false` if the queue is empty.
+  bool pop(T& value);
+  bool empty() const;
+
+private:
+  struct Node
+  {
+    std::atomic<Node*> next{nullptr};
+    T value{};
+  };
+
+  std::atomic<Node*> head_;
+  Node* tail_;
+};
+
+template<typename T>
+MpscQueue<T>::MpscQueue()
+:
+  head_{new Node{}}
+{
+  tail_ = head_.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+MpscQueue<T>::~MpscQueue()
+{
+  while (tail_)
+  {
+    auto next = tail_->next.load(std::memory_order_relaxed);
+    delete tail_;
+    tail_ = next;
+  }
+}
+
+template<typename T>
+void
+MpscQueue<T>::push(T value)
+{
+  auto node = new Node{};
+  node->value = std::move(value);
+  auto prev = head_.exchange(node, std::memory_order_acq_rel);
+  prev->next.store(node, std::memory_order_release);
+}
+
+template<typename T>
+bool
+MpscQueue<T>::pop(T& value)
+{
+  auto next = tail_->next.load(std::memory_order_acquire);
+  if (not next)
+  {
+    return false;
+  }
+  value = std::move(next->value);
+  delete tail_;
+  tail_ = next;
+  return true;
+}
+
+template<typename T>
+bool
+MpscQueue<T>::empty() const
+{
+  return not tail_->next.load(std::memory_order_acquire);
+}
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_DETAIL_MPSCQUEUE_H */
@@ -0,0 +1,216 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Numa.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace drautomaton { namespace detail {
+
+#ifdef __linux__
+
+namespace {
+
+// Parse a list of CPUs like "0-3,8,10-11".
+std::vector<int>
+parseCpuList(const std::string& list)
+{
+  std::vector<int> result{};
+  std::size_t pos = 0;
+  while (pos < list.size())
+  {
+    auto end = list.find(',', pos);
+    if (end == std::string::npos)
+    {
+      end = list.size();
+    }
+    auto range = list.substr(pos, end - pos);
+    auto dash = range.find('-');
+    try
+    {
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int id = first; id <= last; ++id)
+      {
+        result.push_back(id);
+      }
+    }
+    catch (const std::exception&)
+    {
+      // Ignore malformed entries (and the trailing newline).
+    }
+    pos = end + 1;
+  }
+  return result;
+}
+
+} // namespace
+
+std::vector<Cpu>
+cpus()
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) != 0)
+  {
+    return {};
+  }
+
+  std::vector<Cpu> result{};
+  for (int id = 0; id < CPU_SETSIZE; ++id)
+  {
+    if (CPU_ISSET(id, &set))
+    {
+      result.push_back({id, 0});
+    }
+  }
+
+  // Look up the node of every CPU.
+  if (auto dir = opendir("/sys/devices/system/node"))
+  {
+    while (auto entry = readdir(dir))
+    {
+      std::string name{entry->d_name};
+      if (name.compare(0, 4, "node") != 0 or name.size() == 4
+          or name.find_first_not_of("0123456789", 4) != std::string::npos)
+      {
+        continue;
+      }
+      int node = std::stoi(name.substr(4));
+      std::ifstream file{"/sys/devices/system/node/" + name + "/cpulist"};
+      std::string list{};
+      std::getline(file, list);
+      for (auto id : parseCpuList(list))
+      {
+        for (auto& cpu : result)
+        {
+          if (cpu.id == id)
+          {
+            cpu.node = node;
+          }
+        }
+      }
+    }
+    closedir(dir);
+  }
+
+  std::sort(
+      result.begin(), result.end(),
+      [] (const Cpu& lhs, const Cpu& rhs)
+      {
+        return lhs.node < rhs.node or (lhs.node == rhs.node and lhs.id < rhs.id);
+      }
+    );
+  return result;
+}
+
+bool
+pinThread(const std::vector<Cpu>& cpus)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (const auto& cpu : cpus)
+  {
+    if (cpu.id < 0 or cpu.id >= CPU_SETSIZE)
+    {
+      return false;
+    }
+    CPU_SET(cpu.id, &set);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+bool
+countBytesPerNode(const void* data, std::size_t size, std::vector<std::size_t>& bytes)
+{
+  if (size == 0)
+  {
+    return true;
+  }
+
+  auto page_size = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+  auto begin = reinterpret_cast<std::uintptr_t>(data);
+  auto end = begin + size;
+
+  // Query the pages in batches.
+  constexpr std::size_t batch = 256;
+  void* pages[batch];
+  int status[batch];
+  auto page = begin - begin % page_size;
+  while (page < end)
+  {
+    std::size_t count = 0;
+    for (; count < batch and page + count * page_size < end; ++count)
+    {
+      pages[count] = reinterpret_cast<void*>(page + count * page_size);
+    }
+    if (syscall(SYS_move_pages, 0, count, pages, nullptr, status, 0) != 0)
+    {
+      return false;
+    }
+    for (std::size_t i = 0; i < count; ++i, page += page_size)
+    {
+      if (status[i] < 0)
+      {
+        continue;
+      }
+      auto node = static_cast<std::size_t>(status[i]);
+      if (bytes.size() <= node)
+      {
+        bytes.resize(node + 1);
+      }
+      bytes[node] += std::min(end, page + page_size) - std::max(begin, page);
+    }
+  }
+  return true;
+}
+
+#else
+
+std::vector<Cpu>
+cpus()
+{
+  return {};
+}
+
+bool
+pinThread(const std::vector<Cpu>&)
+{
+  return false;
+}
+
+bool
+countBytesPerNode(const void*, std::size_t, std::vector<std::size_t>&)
+{
+  return false;
+}
+
+#endif
+
+}} // namespace drautomaton::detail
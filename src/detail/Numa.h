@@ -0,0 +1,58 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_NUMA_H
+#define DRAUTOMATON_SRC_DETAIL_NUMA_H
+
+#include <cstddef>
+#include <vector>
+
+namespace drautomaton { namespace detail {
+
+/* Numa
+
+Queries of the NUMA topology of the host and of the placement of
+memory, and pinning of threads to CPUs. Backed by Linux' sysfs,
+`move_pages` and `pthread_setaffinity_np`; on other platforms, all
+queries fail.
+*/
+
+struct Cpu
+{
+  int id;
+  int node;
+};
+
+// Return the CPUs the calling thread may run on, ordered by NUMA node
+// and id. If the topology is unknown, every CPU is assigned to node 0.
+// Returns an empty list on failure.
+std::vector<Cpu> cpus();
+
+// Restrict the calling thread to the CPUs `cpus`. Return `false` on
+// failure.
+bool pinThread(const std::vector<Cpu>& cpus);
+
+// Add the number of bytes of `[data, data + size)` which reside on
+// NUMA node `n` to `bytes[n]`, for every node. `bytes` is grown as
+// required. Pages which haven't been touched yet are skipped. Return
+// `false` if the placement can't be determined.
+bool countBytesPerNode(const void* data, std::size_t size, std::vector<std::size_t>& bytes);
+
+}} // namespace drautomaton::detail
+
+#endif /* DRAUTOMATON_SRC_DETAIL_NUMA_H */
@@ -0,0 +1,187 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace drprof {
+
+double
+Counters::ipc() const
+{
+  if (values[cycles] == 0)
+  {
+    return 0.0;
+  }
+  return static_cast<double>(values[instructions]) / values[cycles];
+}
+
+Counters&
+Counters::operator+=(const Counters& other)
+{
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    values[i] += other.values[i];
+  }
+  return *this;
+}
+
+PerfCounters::~PerfCounters()
+{
+  close();
+}
+
+bool
+PerfCounters::isOpen() const
+{
+  return leader_ != -1;
+}
+
+#ifdef __linux__
+
+namespace {
+
+int
+openEvent(std::uint32_t type, std::uint64_t config, int group)
+{
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = (group == -1) ? 1 : 0;  // Leader starts the group.
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+}
+
+} // namespace
+
+bool
+PerfCounters::open()
+{
+  if (isOpen())
+  {
+    return true;
+  }
+
+  struct Event
+  {
+    std::uint32_t type;
+    std::uint64_t config;
+  };
+  const Event events[Counters::size] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},  // Last level cache.
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+  };
+
+  leader_ = openEvent(events[0].type, events[0].config, -1);
+  if (leader_ == -1)
+  {
+    return false;
+  }
+  fds_[0] = leader_;
+  order_[0] = Counters::cycles;
+  num_open_ = 1;
+
+  // Unsupported counters are skipped.
+  for (int i = 1; i < Counters::size; ++i)
+  {
+    int fd = openEvent(events[i].type, events[i].config, leader_);
+    if (fd != -1)
+    {
+      fds_[num_open_] = fd;
+      order_[num_open_] = i;
+      ++num_open_;
+    }
+  }
+
+  ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+}
+
+void
+PerfCounters::close()
+{
+  for (std::size_t i = 0; i < num_open_; ++i)
+  {
+    ::close(fds_[i]);
+    fds_[i] = -1;
+  }
+  leader_ = -1;
+  num_open_ = 0;
+}
+
+bool
+PerfCounters::read(Counters& out) const
+{
+  if (not isOpen())
+  {
+    return false;
+  }
+
+  // Layout for PERF_FORMAT_GROUP: { nr, values[nr] }.
+  std::uint64_t data[1 + Counters::size];
+  auto bytes = ::read(leader_, data, sizeof(data));
+  if (bytes < static_cast<ssize_t>(sizeof(std::uint64_t)) or data[0] != num_open_)
+  {
+    return false;
+  }
+  for (std::size_t i = 0; i < num_open_; ++i)
+  {
+    out.values[order_[i]] = data[1 + i];
+  }
+  return true;
+}
+
+#else
+
+bool
+PerfCounters::open()
+{
+  return false;
+}
+
+void
+PerfCounters::close()
+{}
+
+bool
+PerfCounters::read(Counters&) const
+{
+  return false;
+}
+
+#endif
+
+} // namespace drprof
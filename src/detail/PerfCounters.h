@@ -0,0 +1,92 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_PERFCOUNTERS_H
+#define DRAUTOMATON_SRC_DETAIL_PERFCOUNTERS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace drprof {
+
+/* Counters
+
+Values of the hardware performance counters. A value is zero if the
+counter is not supported by the host.
+*/
+
+struct Counters
+{
+  enum Index
+  {
+    cycles, instructions, l1d_misses, llc_misses, branch_misses, size
+  };
+
+  std::uint64_t values[size]{};
+
+  // Instructions per cycle.
+  double ipc() const;
+
+  Counters& operator+=(const Counters&);
+};
+
+/* PerfCounters
+
+Group of hardware performance counters of the calling thread, backed by
+Linux' `perf_event_open`. Only user space is counted.
+
+On other platforms, or if the kernel denies access (see
+`/proc/sys/kernel/perf_event_paranoid`), `open` fails and the object
+remains unusable.
+
+The counters count the thread which called `open` only. They must not
+be read from any other thread.
+*/
+
+class PerfCounters
+{
+public:
+  PerfCounters() = default;
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // Open and start the counters of the calling thread. Return `true` if
+  // at least the cycle counter is available.
+  bool open();
+  void close();
+  bool isOpen() const;
+
+  // Read the current (cumulative) counter values into `out`. Return
+  // `false` on failure.
+  bool read(Counters& out) const;
+
+private:
+  int leader_ = -1;
+  int fds_[Counters::size] = {-1, -1, -1, -1, -1};
+
+  // Indices into `Counters::values` in the order the counters were
+  // added to the group.
+  int order_[Counters::size]{};
+  std::size_t num_open_ = 0;
+};
+
+} // namespace drprof
+
+#endif /* DRAUTOMATON_SRC_DETAIL_PERFCOUNTERS_H */
@@ -18,33 +18,766 @@
 
 #include "Profiling.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 namespace drprof {
 
-std::unordered_map<
-    std::string,
-    std::tuple<
-        std::chrono::high_resolution_clock::time_point,
-        unsigned int,
-        unsigned int
-      >
-  > tags_{};
+namespace {
+
+constexpr std::size_t chunk_size = 1024;  // Events per chunk.
+constexpr std::size_t max_chunks = 256;   // Chunks per thread.
+constexpr std::size_t max_tags = 256;     // Must be a power of two.
+constexpr std::size_t max_depth = 64;     // Maximum nesting of sections.
+
+struct Event
+{
+  std::uint64_t id;
+  const char* name;
+  std::int64_t begin;  // Nanoseconds since `epoch()`.
+  std::int64_t end;
+  bool counted;  // True if `counters` is valid.
+  Counters counters;
+  Allocations allocations;
+};
+
+struct Chunk
+{
+  Event events[chunk_size];
+};
+
+struct Aggregate
+{
+  std::atomic<std::uint64_t> id{0};  // Zero if the slot is empty.
+  std::atomic<const char*> name{nullptr};
+  std::atomic<std::uint64_t> ns{0};
+  std::atomic<std::uint64_t> passes{0};
+  std::atomic<std::uint64_t> counted{0};  // Passes with counters.
+  std::atomic<std::uint64_t> counters[Counters::size]{};
+  std::atomic<std::uint64_t> allocations{0};
+  std::atomic<std::uint64_t> allocated_bytes{0};
+};
+
+struct Frame
+{
+  std::uint64_t id;
+  const char* name;
+  std::int64_t begin;
+  bool counted;
+  Counters counters;
+  Allocations allocations;
+};
+
+// Allocation counters. The thread-local variables are constant
+// initialized, so that they may be safely used by `operator new`.
+std::atomic<bool> counting_allocations{false};
+std::atomic<std::uint64_t> total_allocations{0};
+std::atomic<std::uint64_t> total_allocated_bytes{0};
+thread_local std::uint64_t thread_allocations = 0;
+thread_local std::uint64_t thread_allocated_bytes = 0;
+thread_local int internal_depth = 0;
+
+// While an `Internal` object exists, allocations made by the calling
+// thread are attributed to the profiler and not counted.
+struct Internal
+{
+  Internal() { ++internal_depth; }
+  ~Internal() { --internal_depth; }
+};
+
+/* Buffer
+
+Per-thread profiling data. Written only by the owning thread, read by
+any thread. The owner publishes new data using release stores.
+*/
+
+struct Buffer
+{
+  explicit Buffer(int lane) : lane{lane} {}
+
+  ~Buffer()
+  {
+    for (auto& chunk : chunks)
+    {
+      delete chunk.load();
+    }
+  }
+
+  const int lane;
+  std::atomic<const char*> name{nullptr};
+  std::atomic<std::size_t> size{0};  // Number of logged events.
+  std::atomic<std::uint64_t> dropped{0};
+  std::atomic<Chunk*> chunks[max_chunks]{};
+  Aggregate aggregates[max_tags]{};
+
+  // Owner only.
+  Frame stack[max_depth];
+  std::size_t depth = 0;
+};
+
+struct Registry
+{
+  std::mutex mutex{};
+  std::vector<std::unique_ptr<Buffer>> buffers{};
+  std::vector<Buffer*> free{};
+};
+
+// The registry is never destroyed, so that threads which terminate
+// after `main` may still return their buffers.
+Registry&
+registry()
+{
+  static auto result = new Registry{};
+  return *result;
+}
+
+Buffer*
+acquire()
+{
+  Internal internal{};
+  auto& r = registry();
+  std::lock_guard<std::mutex> lock{r.mutex};
+  if (not r.free.empty())
+  {
+    auto buffer = r.free.back();
+    r.free.pop_back();
+    return buffer;
+  }
+  r.buffers.push_back(std::make_unique<Buffer>(r.buffers.size() + 1));
+  return r.buffers.back().get();
+}
+
+void
+release(Buffer* buffer)
+{
+  Internal internal{};
+  buffer->depth = 0;
+  buffer->name.store(nullptr, std::memory_order_relaxed);
+  auto& r = registry();
+  std::lock_guard<std::mutex> lock{r.mutex};
+  r.free.push_back(buffer);
+}
+
+// Return buffer to the registry when the thread terminates.
+struct Handle
+{
+  ~Handle()
+  {
+    if (buffer)
+    {
+      release(buffer);
+    }
+  }
+
+  Buffer* buffer = nullptr;
+
+  // The hardware counters count the owning thread, so they are not
+  // recycled with the buffer.
+  PerfCounters perf{};
+  bool perf_failed = false;
+};
+
+std::atomic<bool> counters_enabled{false};
+
+thread_local Handle handle{};
+
+Buffer&
+local()
+{
+  if (not handle.buffer)
+  {
+    handle.buffer = acquire();
+  }
+  return *handle.buffer;
+}
+
+bool
+readCounters(Counters& out)
+{
+  if (not handle.perf.isOpen())
+  {
+    if (handle.perf_failed)
+    {
+      return false;
+    }
+    if (not handle.perf.open())
+    {
+      handle.perf_failed = true;
+      return false;
+    }
+  }
+  return handle.perf.read(out);
+}
+
+Clock::time_point
+epoch()
+{
+  static const auto result = Clock::now();
+  return result;
+}
+
+std::int64_t
+now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      Clock::now() - epoch()
+    ).count();
+}
+
+// Owner only.
+Aggregate&
+aggregate(Buffer& buffer, std::uint64_t id, const char* name)
+{
+  auto index = id & (max_tags - 1);
+  for (std::size_t i = 0; i < max_tags; ++i)
+  {
+    auto& slot = buffer.aggregates[(index + i) & (max_tags - 1)];
+    auto slot_id = slot.id.load(std::memory_order_relaxed);
+    if (slot_id == id)
+    {
+      return slot;
+    }
+    if (slot_id == 0)
+    {
+      slot.name.store(name, std::memory_order_relaxed);
+      slot.id.store(id, std::memory_order_release);
+      return slot;
+    }
+  }
+  throw std::runtime_error{"drprof: too many tags"};
+}
+
+// Owner only.
+void
+log(Buffer& buffer, const Event& event)
+{
+  auto n = buffer.size.load(std::memory_order_relaxed);
+  auto index = n / chunk_size;
+  if (index >= max_chunks)
+  {
+    buffer.dropped.store(
+        buffer.dropped.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed
+      );
+    return;
+  }
+
+  auto chunk = buffer.chunks[index].load(std::memory_order_relaxed);
+  if (not chunk)
+  {
+    Internal internal{};
+    chunk = new Chunk;
+    buffer.chunks[index].store(chunk, std::memory_order_release);
+  }
+  chunk->events[n % chunk_size] = event;
+  buffer.size.store(n + 1, std::memory_order_release);
+}
+
+void
+add(std::atomic<std::uint64_t>& x, std::uint64_t value)
+{
+  x.store(x.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct Summary
+{
+  std::string name{};
+  std::uint64_t ns = 0;
+  std::uint64_t passes = 0;
+  std::uint64_t counted = 0;
+  Counters counters{};
+  Allocations allocations{};
+};
+
+Summary&
+operator+=(Summary& summary, const Aggregate& slot)
+{
+  summary.name = slot.name.load(std::memory_order_relaxed);
+  summary.ns += slot.ns.load(std::memory_order_relaxed);
+  summary.passes += slot.passes.load(std::memory_order_relaxed);
+  summary.counted += slot.counted.load(std::memory_order_relaxed);
+  summary.allocations.count += slot.allocations.load(std::memory_order_relaxed);
+  summary.allocations.bytes += slot.allocated_bytes.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < Counters::size; ++i)
+  {
+    summary.counters.values[i] += slot.counters[i].load(std::memory_order_relaxed);
+  }
+  return summary;
+}
+
+// Sum the aggregates of all threads.
+std::map<std::uint64_t, Summary>
+summarize()
+{
+  Internal internal{};
+  std::map<std::uint64_t, Summary> result{};
+  auto& r = registry();
+  std::lock_guard<std::mutex> lock{r.mutex};
+  for (const auto& buffer : r.buffers)
+  {
+    for (const auto& slot : buffer->aggregates)
+    {
+      auto id = slot.id.load(std::memory_order_acquire);
+      if (id == 0)
+      {
+        continue;
+      }
+      result[id] += slot;
+    }
+  }
+  return result;
+}
+
+Summary
+summarize(const std::string& tag)
+{
+  auto summaries = summarize();
+  auto it = summaries.find(tagId(tag));
+  if (it == summaries.end())
+  {
+    Summary result{};
+    result.name = tag;
+    return result;
+  }
+  return it->second;
+}
+
+// Write miss rates per thousand instructions.
+void
+printRates(std::ostream& os, std::uint64_t passes, const Counters& counters)
+{
+  const auto& v = counters.values;
+  auto kinst = v[Counters::instructions] / 1000.0;
+  auto mpki = [&] (std::uint64_t misses) { return kinst > 0 ? misses / kinst : 0.0; };
+  auto flags = os.flags();
+  auto precision = os.precision();
+  os << std::fixed << std::setprecision(2)
+     << "IPC " << counters.ipc()
+     << "; " << v[Counters::cycles] / std::max<std::uint64_t>(passes, 1) << " cycles/pass"
+     << "; L1D MPKI " << mpki(v[Counters::l1d_misses])
+     << "; LLC MPKI " << mpki(v[Counters::llc_misses])
+     << "; branch MPKI " << mpki(v[Counters::branch_misses]);
+  os.flags(flags);
+  os.precision(precision);
+}
+
+const char* const counter_names[Counters::size] = {
+  "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses"
+};
+
+std::string
+escape(const std::string& s)
+{
+  std::string result{};
+  for (auto c : s)
+  {
+    if (c == '"' or c == '\\')
+    {
+      result += '\\';
+    }
+    result += c;
+  }
+  return result;
+}
+
+} // namespace
+
+void
+start(std::uint64_t id, const char* name)
+{
+  auto& buffer = local();
+  assert(buffer.depth < max_depth && "drprof: sections nested too deeply");
+  if (buffer.depth < max_depth)
+  {
+    auto& frame = buffer.stack[buffer.depth];
+    frame.id = id;
+    frame.name = name;
+    frame.counted = counters_enabled.load(std::memory_order_relaxed)
+                    and readCounters(frame.counters);
+    frame.allocations = {thread_allocations, thread_allocated_bytes};
+    frame.begin = now();
+  }
+  ++buffer.depth;
+}
+
+void
+stop(std::uint64_t id)
+{
+  auto end = now();
+  auto& buffer = local();
+  assert(buffer.depth > 0 && "drprof: stop without start");
+  if (buffer.depth == 0)
+  {
+    return;
+  }
+  --buffer.depth;
+  if (buffer.depth >= max_depth)
+  {
+    return;
+  }
+
+  const auto& frame = buffer.stack[buffer.depth];
+  assert(frame.id == id && "drprof: stop does not match innermost start");
+  (void)id;
+
+  Event event{
+      frame.id, frame.name, frame.begin, end, false, {},
+      {
+        thread_allocations - frame.allocations.count,
+        thread_allocated_bytes - frame.allocations.bytes
+      }
+    };
+  if (frame.counted and readCounters(event.counters))
+  {
+    event.counted = true;
+    for (std::size_t i = 0; i < Counters::size; ++i)
+    {
+      event.counters.values[i] -= frame.counters.values[i];
+    }
+  }
+
+  auto& slot = aggregate(buffer, frame.id, frame.name);
+  add(slot.ns, end - frame.begin);
+  add(slot.passes, 1);
+  add(slot.allocations, event.allocations.count);
+  add(slot.allocated_bytes, event.allocations.bytes);
+  if (event.counted)
+  {
+    add(slot.counted, 1);
+    for (std::size_t i = 0; i < Counters::size; ++i)
+    {
+      add(slot.counters[i], event.counters.values[i]);
+    }
+  }
+  log(buffer, event);
+}
+
+void
+setThreadName(const char* name)
+{
+  local().name.store(name, std::memory_order_relaxed);
+}
 
 unsigned int
 getTime(const std::string& tag)
 {
-  auto it = drprof::tags_.find(tag);
-  assert(it != drprof::tags_.end() && "No such tag");
-  return std::get<1>(std::get<1>(*it)) / 1000;
+  return summarize(tag).ns / 1000000;
+}
+
+std::uint64_t
+getTimeNs(const std::string& tag)
+{
+  return summarize(tag).ns;
 }
 
 unsigned int
 getPasses(const std::string& tag)
 {
-  auto it = drprof::tags_.find(tag);
-  assert(it != drprof::tags_.end() && "No such tag");
-  return std::get<2>(std::get<1>(*it));
+  return summarize(tag).passes;
+}
+
+bool
+enableCounters(bool enable)
+{
+  counters_enabled.store(enable, std::memory_order_relaxed);
+  Counters dummy{};
+  return enable and readCounters(dummy);
+}
+
+bool
+countersEnabled()
+{
+  return counters_enabled.load(std::memory_order_relaxed);
+}
+
+Counters
+getCounters(const std::string& tag)
+{
+  return summarize(tag).counters;
+}
+
+std::vector<ThreadCounters>
+getThreadCounters(const std::string& tag)
+{
+  Internal internal{};
+  std::vector<ThreadCounters> result{};
+  auto id = tagId(tag);
+  auto& r = registry();
+  std::lock_guard<std::mutex> lock{r.mutex};
+  for (const auto& buffer : r.buffers)
+  {
+    for (const auto& slot : buffer->aggregates)
+    {
+      if (slot.id.load(std::memory_order_acquire) != id)
+      {
+        continue;
+      }
+      Summary summary{};
+      summary += slot;
+      if (summary.counted == 0)
+      {
+        continue;
+      }
+      auto name = buffer->name.load(std::memory_order_relaxed);
+      result.push_back({
+          buffer->lane,
+          name ? name : "thread " + std::to_string(buffer->lane),
+          summary.counted,
+          summary.counters
+        });
+    }
+  }
+  return result;
+}
+
+void
+recordAllocation(std::size_t bytes) noexcept
+{
+  if (internal_depth > 0)
+  {
+    return;
+  }
+  ++thread_allocations;
+  thread_allocated_bytes += bytes;
+  total_allocations.fetch_add(1, std::memory_order_relaxed);
+  total_allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+  counting_allocations.store(true, std::memory_order_relaxed);
+}
+
+bool
+countingAllocations()
+{
+  return counting_allocations.load(std::memory_order_relaxed);
+}
+
+Allocations
+allocations()
+{
+  return {
+      total_allocations.load(std::memory_order_relaxed),
+      total_allocated_bytes.load(std::memory_order_relaxed)
+    };
+}
+
+Allocations
+threadAllocations()
+{
+  return {thread_allocations, thread_allocated_bytes};
+}
+
+Allocations
+getAllocations(const std::string& tag)
+{
+  return summarize(tag).allocations;
+}
+
+void*
+allocate(std::size_t size) noexcept
+{
+  recordAllocation(size);
+  return std::malloc(size ? size : 1);
+}
+
+void*
+allocateAligned(std::size_t size, std::size_t alignment) noexcept
+{
+  recordAllocation(size);
+
+  // `aligned_alloc` requires the size to be a multiple of the alignment.
+  size = (size + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+  return _aligned_malloc(size ? size : alignment, alignment);
+#else
+  return std::aligned_alloc(alignment, size ? size : alignment);
+#endif
+}
+
+void
+deallocate(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+deallocateAligned(void* ptr) noexcept
+{
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+void
+print(std::ostream& os, const std::string& tag)
+{
+  auto summary = summarize(tag);
+  os << "DrProf: " << tag << ": " << summary.ns / 1000000 << "ms" << "; "
+     << summary.passes << " passes";
+  if (countingAllocations())
+  {
+    os << "; " << summary.allocations.count << " allocations ("
+       << summary.allocations.bytes << " bytes)";
+  }
+  if (summary.counted > 0)
+  {
+    os << "; ";
+    printRates(os, summary.counted, summary.counters);
+  }
+  os << std::endl;
+}
+
+void
+printAll(std::ostream& os)
+{
+  for (const auto& p : summarize())
+  {
+    print(os, p.second.name);
+  }
+}
+
+void
+printCounters(std::ostream& os)
+{
+  for (const auto& p : summarize())
+  {
+    if (p.second.counted == 0)
+    {
+      continue;
+    }
+    os << "DrProf: " << p.second.name << ":" << std::endl;
+    for (const auto& thread : getThreadCounters(p.second.name))
+    {
+      os << "  " << thread.thread << ": " << thread.passes << " passes; ";
+      printRates(os, thread.passes, thread.counters);
+      os << std::endl;
+    }
+  }
+}
+
+void
+writeTrace(std::ostream& os)
+{
+  Internal internal{};
+  auto& r = registry();
+  std::lock_guard<std::mutex> lock{r.mutex};
+
+  os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  auto separator = [&] () {
+    if (not first)
+    {
+      os << ",\n";
+    }
+    first = false;
+  };
+
+  os << std::fixed << std::setprecision(3);
+  for (const auto& buffer : r.buffers)
+  {
+    auto name = buffer->name.load(std::memory_order_relaxed);
+    separator();
+    os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->lane
+       << ",\"args\":{\"name\":\""
+       << escape(name ? name : "thread " + std::to_string(buffer->lane))
+       << "\"}}";
+
+    // Chrome trace timestamps are in microseconds.
+    auto size = buffer->size.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      auto chunk = buffer->chunks[i / chunk_size].load(std::memory_order_acquire);
+      const auto& event = chunk->events[i % chunk_size];
+      separator();
+      os << "{\"name\":\"" << escape(event.name)
+         << "\",\"cat\":\"drautomaton\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->lane
+         << ",\"ts\":" << event.begin / 1000.0
+         << ",\"dur\":" << (event.end - event.begin) / 1000.0;
+      if (event.counted or event.allocations.count > 0)
+      {
+        os << ",\"args\":{";
+        if (event.counted)
+        {
+          for (std::size_t j = 0; j < Counters::size; ++j)
+          {
+            os << "\"" << counter_names[j] << "\":" << event.counters.values[j] << ",";
+          }
+          os << "\"ipc\":" << event.counters.ipc();
+        }
+        if (event.allocations.count > 0)
+        {
+          os << (event.counted ? "," : "")
+             << "\"allocations\":" << event.allocations.count
+             << ",\"allocated_bytes\":" << event.allocations.bytes;
+        }
+        os << "}";
+      }
+      os << "}";
+    }
+  }
+  os << "]}" << std::endl;
+}
+
+bool
+writeTrace(const std::string& path)
+{
+  std::ofstream file{path};
+  if (not file)
+  {
+    return false;
+  }
+  writeTrace(file);
+  return static_cast<bool>(file);
+}
+
+std::uint64_t
+droppedEvents()
+{
+  std::uint64_t result = 0;
+  auto& r = registry();
+  std::lock_guard<std::mutex> lock{r.mutex};
+  for (const auto& buffer : r.buffers)
+  {
+    result += buffer->dropped.load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+void
+reset()
+{
+  auto& r = registry();
+  std::lock_guard<std::mutex> lock{r.mutex};
+  for (const auto& buffer : r.buffers)
+  {
+    buffer->size.store(0, std::memory_order_relaxed);
+    buffer->dropped.store(0, std::memory_order_relaxed);
+    for (auto& slot : buffer->aggregates)
+    {
+      slot.id.store(0, std::memory_order_relaxed);
+      slot.ns.store(0, std::memory_order_relaxed);
+      slot.passes.store(0, std::memory_order_relaxed);
+      slot.counted.store(0, std::memory_order_relaxed);
+      slot.allocations.store(0, std::memory_order_relaxed);
+      slot.allocated_bytes.store(0, std::memory_order_relaxed);
+      for (auto& counter : slot.counters)
+      {
+        counter.store(0, std::memory_order_relaxed);
+      }
+    }
+  }
 }
 
 } // namespace drprof
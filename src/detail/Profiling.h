@@ -20,65 +20,201 @@
 #define DRAUTOMATON_SRC_PROFILING_H
 
 #include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <iostream>
-#include <tuple>
-#include <unordered_map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "PerfCounters.h"
+
+/* drprof
+
+Thread-safe profiler. Profiling is enabled by defining `DRAUTO_PROFILING`
+before including this header; otherwise, the `DRPROF_*` macros expand to
+nothing.
+
+Every tag is identified by a hash of its name, which is computed at
+compile time by the macros. Each thread records into its own buffer,
+which is written by that thread only, so recording requires neither
+locks nor string hashing. Every buffer holds the thread's aggregated
+time and number of passes per tag, and a bounded log of individual
+events (timestamps in nanoseconds), which may be exported in the Chrome
+trace event format (viewable in `chrome://tracing` or Perfetto) using
+`writeTrace`. Once the log of a thread is full, further events of that
+thread are counted as dropped, but the aggregates remain exact.
+
+The buffers of terminated threads are recycled by new threads. Thus, a
+trace lane may show the events of several threads which never ran at
+the same time.
+
+On Linux, the hardware performance counters of each thread (cycles,
+instructions, L1D/LLC misses, branch misses) may be attached to every
+section by calling `enableCounters(true)`. The counters are then read
+at the start and end of each section, which costs a system call each.
+The accumulated counter values are reported per tag and per thread.
+
+Heap allocations are counted once the global `operator new` is replaced
+by including `detail/CountAllocations.h` in one source file of the
+executable. The number and size of the allocations made during each
+section are then aggregated per tag. Allocations made by the profiler
+itself are not counted.
+
+`getTime`, `getPasses`, `get*Counters`, `print*` and `writeTrace` may be
+called at any time and from any thread. `reset` must only be called
+while no other thread is profiling.
+*/
 
 namespace drprof {
 
-extern std::unordered_map<
-    std::string,
-    std::tuple<
-        std::chrono::high_resolution_clock::time_point,
-        unsigned int,
-        unsigned int
-      >
-  > tags_;
+using Clock = std::chrono::steady_clock;
+
+// Return 64-bit FNV-1a hash of `name`.
+constexpr std::uint64_t
+tagId(const char* name)
+{
+  std::uint64_t hash = 14695981039346656037ull;
+  for (; *name != '\0'; ++name)
+  {
+    hash = (hash ^ static_cast<unsigned char>(*name)) * 1099511628211ull;
+  }
+  return hash;
+}
+
+inline std::uint64_t
+tagId(const std::string& name)
+{
+  return tagId(name.c_str());
+}
+
+// Open/close the section `id` on the calling thread. `name` must point
+// to a string with static storage duration (usually a literal). Calls
+// must be properly nested.
+void start(std::uint64_t id, const char* name);
+void stop(std::uint64_t id);
+
+// Set the name of the calling thread's trace lane. `name` must point to
+// a string with static storage duration.
+void setThreadName(const char* name);
+
+// Return accumulated time in milliseconds/nanoseconds and number of
+// passes of `tag`, summed over all threads. Return zero if the tag was
+// never recorded.
+unsigned int getTime(const std::string& tag);
+std::uint64_t getTimeNs(const std::string& tag);
+unsigned int getPasses(const std::string& tag);
+
+// Enable/disable hardware performance counters. Return `true` if the
+// counters are available on the calling thread.
+bool enableCounters(bool);
+bool countersEnabled();
+
+struct ThreadCounters
+{
+  int lane;
+  std::string thread;
+  std::uint64_t passes;  // Number of passes with counters.
+  Counters counters;
+};
+
+// Return accumulated hardware counter values of `tag`, summed over all
+// threads/for each thread. Only passes which were recorded while the
+// counters were enabled are accounted for.
+Counters getCounters(const std::string& tag);
+std::vector<ThreadCounters> getThreadCounters(const std::string& tag);
+
+struct Allocations
+{
+  std::uint64_t count = 0;
+  std::uint64_t bytes = 0;
+};
 
-unsigned int getTime(const std::string&);
-unsigned int getPasses(const std::string&);
+// Record an allocation of `bytes` bytes made by the calling thread.
+// Called by the replacements of `operator new`.
+void recordAllocation(std::size_t bytes) noexcept;
+
+// Return `true` if allocations are counted.
+bool countingAllocations();
+
+// Return number and size of the allocations made since program start
+// by all threads/by the calling thread.
+Allocations allocations();
+Allocations threadAllocations();
+
+// Return number and size of the allocations made during passes of
+// `tag`, summed over all threads.
+Allocations getAllocations(const std::string& tag);
+
+// Allocate and record/free memory. Used by the replacements of
+// `operator new` and `operator delete`. Return `nullptr` on failure.
+void* allocate(std::size_t size) noexcept;
+void* allocateAligned(std::size_t size, std::size_t alignment) noexcept;
+void deallocate(void*) noexcept;
+void deallocateAligned(void*) noexcept;
+
+// Print statistics of `tag`/all tags.
+void print(std::ostream&, const std::string& tag);
+void printAll(std::ostream&);
+
+// Print hardware counter statistics of all tags per thread.
+void printCounters(std::ostream&);
+
+// Write all recorded events in the Chrome trace event format.
+void writeTrace(std::ostream&);
+bool writeTrace(const std::string& path);
+
+// Return number of events which were not logged because a thread's
+// event log was full.
+std::uint64_t droppedEvents();
+
+// Clear all aggregates and event logs.
+void reset();
+
+/* Scope
+
+RAII guard that opens a section on construction and closes it on
+destruction.
+*/
+
+class Scope
+{
+public:
+  Scope(std::uint64_t id, const char* name) : id_{id} { start(id, name); }
+  ~Scope() { stop(id_); }
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+private:
+  std::uint64_t id_;
+};
 
 } // namespace drprof
 
 #ifdef DRAUTO_PROFILING
 
-#define DRPROF_START(tag) \
-do { \
-  auto it = drprof::tags_.insert(std::make_pair(tag, std::make_tuple(std::chrono::high_resolution_clock::time_point{}, 0, 0))).first; \
-  std::get<0>(std::get<1>(*it)) = std::chrono::high_resolution_clock::now(); \
-} while(0)
-
-#define DRPROF_STOP(tag) \
-do { \
-  auto it = drprof::tags_.find(tag); \
-  assert(it != drprof::tags_.end() && "No such tag: " # tag); \
-  auto t1 = std::chrono::high_resolution_clock::now(); \
-  std::get<1>(std::get<1>(*it)) += std::chrono::duration_cast<std::chrono::microseconds>( \
-      t1 - std::get<0>(std::get<1>(*it)) \
-    ).count(); \
-  std::get<2>(std::get<1>(*it)) += 1; \
-} while(0)
-
-#define DRPROF_PRINT(tag) \
-do { \
-  auto it = drprof::tags_.find(tag); \
-  assert(it != drprof::tags_.end() && "No such tag: " # tag); \
-  std::cout << "DrProf: " << tag << ": " << std::get<1>(std::get<1>(*it)) / 1000 << "ms" << "; " << std::get<2>(std::get<1>(*it)) << " passes" << std::endl; \
-} while(0)
-
-#define DRPROF_PRINT_ALL() \
-do { \
-  for (const auto& tag : drprof::tags_) \
-  { \
-    DRPROF_PRINT(std::get<0>(tag)); \
-  } \
-} while(0)
+#define DRPROF_ID(tag) \
+  (std::integral_constant<std::uint64_t, drprof::tagId(tag)>::value)
+
+#define DRPROF_CONCAT_IMPL(a, b) a ## b
+#define DRPROF_CONCAT(a, b) DRPROF_CONCAT_IMPL(a, b)
+
+#define DRPROF_START(tag) drprof::start(DRPROF_ID(tag), tag)
+#define DRPROF_STOP(tag) drprof::stop(DRPROF_ID(tag))
+#define DRPROF_SCOPE(tag) \
+  drprof::Scope DRPROF_CONCAT(drprof_scope_, __COUNTER__){DRPROF_ID(tag), tag}
+#define DRPROF_THREAD_NAME(name) drprof::setThreadName(name)
+#define DRPROF_PRINT(tag) drprof::print(std::cout, tag)
+#define DRPROF_PRINT_ALL() drprof::printAll(std::cout)
 
 #else
 
 // If profiling is disabled, ignore the macros.
 #define DRPROF_START(...)
 #define DRPROF_STOP(...)
+#define DRPROF_SCOPE(...)
+#define DRPROF_THREAD_NAME(...)
 #define DRPROF_PRINT(...)
 #define DRPROF_PRINT_ALL(...)
 
@@ -0,0 +1,81 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "StreamReader.h"
+
+#include <stdexcept>
+
+namespace drautomaton {
+
+StreamReader::StreamReader(std::istream& in, std::size_t buffer_size)
+:
+  in_{in},
+  buffer_(buffer_size)
+{
+  if (buffer_size == 0)
+  {
+    throw std::runtime_error{"StreamReader requires a buffer"};
+  }
+}
+
+bool
+StreamReader::refill()
+{
+  in_.read(buffer_.data(), buffer_.size());
+  if (in_.bad())
+  {
+    throw std::runtime_error{"failed to read stream"};
+  }
+  pos_ = 0;
+  end_ = static_cast<std::size_t>(in_.gcount());
+  return end_ != 0;
+}
+
+void
+StreamReader::skipLine()
+{
+  for (int c = get(); c != EOF and c != '\n'; c = get())
+  {
+  }
+}
+
+bool
+StreamReader::getLine(std::string& line, std::size_t max_length)
+{
+  line.clear();
+  int c = get();
+  if (c == EOF)
+  {
+    return false;
+  }
+  for (; c != EOF and c != '\n'; c = get())
+  {
+    if (line.size() == max_length)
+    {
+      throw std::runtime_error{"line too long"};
+    }
+    line.push_back(static_cast<char>(c));
+  }
+  if (not line.empty() and line.back() == '\r')
+  {
+    line.pop_back();
+  }
+  return true;
+}
+
+} // namespace drautomaton
@@ -0,0 +1,85 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_STREAMREADER_H
+#define DRAUTOMATON_SRC_DETAIL_STREAMREADER_H
+
+#include <cstdio>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace drautomaton {
+
+/* StreamReader
+
+Character-wise reader of a `std::istream` with a buffer of fixed size,
+so that arbitrarily large streams are read in bounded memory and
+without a virtual call per character.
+*/
+
+class StreamReader
+{
+public:
+  explicit StreamReader(std::istream&, std::size_t buffer_size = 1 << 16);
+
+  // Return the next character as `unsigned char`, or `EOF` at the end of
+  // the stream. Throws if reading fails.
+  int get();
+  int peek();
+
+  // Skip the rest of the current line, including the line break.
+  void skipLine();
+
+  // Read the rest of the current line into `line`, without the line
+  // break (`"\n"` or `"\r\n"`). Returns `false` if the stream is
+  // exhausted. Throws if the line exceeds `max_length` characters.
+  bool getLine(std::string& line, std::size_t max_length = 4096);
+
+private:
+  bool refill();
+
+  std::istream& in_;
+  std::vector<char> buffer_;
+  std::size_t pos_ = 0;
+  std::size_t end_ = 0;
+};
+
+inline int
+StreamReader::get()
+{
+  if (pos_ == end_ and not refill())
+  {
+    return EOF;
+  }
+  return static_cast<unsigned char>(buffer_[pos_++]);
+}
+
+inline int
+StreamReader::peek()
+{
+  if (pos_ == end_ and not refill())
+  {
+    return EOF;
+  }
+  return static_cast<unsigned char>(buffer_[pos_]);
+}
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_DETAIL_STREAMREADER_H */
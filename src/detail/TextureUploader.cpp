@@ -0,0 +1,210 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "TextureUploader.h"
+
+#include <cstring>
+
+#include <QOpenGLContext>
+
+#include "Profiling.h"
+
+namespace drautomaton {
+
+namespace {
+
+bool
+supportsPixelBuffers(QOpenGLContext* context)
+{
+  auto version = qMakePair(context->format().majorVersion(), context->format().minorVersion());
+  if (context->isOpenGLES())
+  {
+    return version >= qMakePair(3, 0);
+  }
+  return version >= qMakePair(2, 1) or context->hasExtension("GL_ARB_pixel_buffer_object");
+}
+
+} // namespace
+
+TextureUploader::TextureUploader(int num_buffers)
+{
+  if (not supportsPixelBuffers(QOpenGLContext::currentContext()))
+  {
+    return;
+  }
+
+  for (int i = 0; i < num_buffers; ++i)
+  {
+    QOpenGLBuffer buffer{QOpenGLBuffer::PixelUnpackBuffer};
+    buffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    if (not buffer.create())
+    {
+      break;
+    }
+    buffers_.push_back(buffer);
+  }
+}
+
+TextureUploader::~TextureUploader()
+{
+  for (auto& buffer : buffers_)
+  {
+    buffer.destroy();
+  }
+}
+
+bool
+TextureUploader::isStreaming() const
+{
+  return not buffers_.empty();
+}
+
+void
+TextureUploader::upload(
+    const QRect& rect,
+    const void* data,
+    int width,
+    int bytes_per_pixel,
+    GLenum format,
+    GLenum type,
+    const QPoint& origin
+  )
+{
+  DRPROF_SCOPE("TextureUploader::upload");
+  if (rect.isEmpty())
+  {
+    return;
+  }
+
+  // The rows are tightly packed, not necessarily 4-byte aligned.
+  auto openGL = QOpenGLContext::currentContext()->functions();
+  openGL->glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  if (not uploadStreaming(rect, data, width, bytes_per_pixel, format, type, origin))
+  {
+    uploadDirect(rect, data, width, bytes_per_pixel, format, type, origin);
+  }
+  openGL->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void
+TextureUploader::uploadDirect(
+    const QRect& rect,
+    const void* data,
+    int width,
+    int bytes_per_pixel,
+    GLenum format,
+    GLenum type,
+    const QPoint& origin
+  )
+{
+  const char* pixels = static_cast<const char*>(data) + rect.top() * width * bytes_per_pixel;
+  if (rect.left() != 0 or rect.width() != width)
+  {
+    staging_.resize(rect.width() * rect.height() * bytes_per_pixel);
+    pack(rect, data, width, bytes_per_pixel, staging_.data());
+    pixels = staging_.data();
+  }
+
+  auto openGL = QOpenGLContext::currentContext()->functions();
+  openGL->glTexSubImage2D(
+      GL_TEXTURE_2D,
+      0, rect.left() - origin.x(), rect.top() - origin.y(),
+      rect.width(), rect.height(),
+      format,
+      type,
+      pixels
+    );
+}
+
+bool
+TextureUploader::uploadStreaming(
+    const QRect& rect,
+    const void* data,
+    int width,
+    int bytes_per_pixel,
+    GLenum format,
+    GLenum type,
+    const QPoint& origin
+  )
+{
+  if (buffers_.empty())
+  {
+    return false;
+  }
+
+  auto& buffer = buffers_[next_];
+  next_ = (next_ + 1) % buffers_.size();
+
+  // Orphan the previous storage (if the GPU is still reading from it,
+  // the driver allocates new storage instead of stalling), then map it.
+  int row_size = rect.width() * bytes_per_pixel;
+  int size = row_size * rect.height();
+  buffer.bind();
+  buffer.allocate(size);
+  auto target = static_cast<char*>(buffer.mapRange(
+      0, size,
+      QOpenGLBuffer::RangeWrite | QOpenGLBuffer::RangeInvalidateBuffer
+    ));
+  if (not target)
+  {
+    // glMapBufferRange is missing on OpenGL < 3.0 without
+    // ARB_map_buffer_range.
+    target = static_cast<char*>(buffer.map(QOpenGLBuffer::WriteOnly));
+  }
+  if (not target)
+  {
+    buffer.release();
+    return false;
+  }
+
+  pack(rect, data, width, bytes_per_pixel, target);
+  buffer.unmap();
+
+  // With a pixel unpack buffer bound, the pointer is an offset into the
+  // buffer.
+  auto openGL = QOpenGLContext::currentContext()->functions();
+  openGL->glTexSubImage2D(
+      GL_TEXTURE_2D,
+      0, rect.left() - origin.x(), rect.top() - origin.y(),
+      rect.width(), rect.height(),
+      format,
+      type,
+      nullptr
+    );
+  buffer.release();
+  return true;
+}
+
+void
+TextureUploader::pack(
+    const QRect& rect,
+    const void* data,
+    int width,
+    int bytes_per_pixel,
+    char* target
+  )
+{
+  int row_size = rect.width() * bytes_per_pixel;
+  auto source = static_cast<const char*>(data) + (rect.top() * width + rect.left()) * bytes_per_pixel;
+  for (int y = 0; y < rect.height(); ++y)
+  {
+    std::memcpy(target + y * row_size, source + y * width * bytes_per_pixel, row_size);
+  }
+}
+
+} // namespace drautomaton
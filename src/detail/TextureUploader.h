@@ -0,0 +1,94 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_TEXTUREUPLOADER_H
+#define DRAUTOMATON_SRC_DETAIL_TEXTUREUPLOADER_H
+
+#include <vector>
+
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include <QRect>
+
+namespace drautomaton {
+
+/* TextureUploader
+
+Streams rectangles of an image in client memory into a texture.
+
+If the OpenGL context supports pixel buffer objects (desktop OpenGL 2.1
+or later, OpenGL ES 3.0 or later), the rectangle is copied into the next
+buffer of a ring of `num_buffers` PBOs, from which the texture is
+updated asynchronously: `glTexSubImage2D` returns immediately, and the
+driver transfers the data while the CPU fills the next buffer. Before
+each copy, the buffer's storage is orphaned, so that the CPU never waits
+for a transfer still in flight. Since the rectangle is packed while
+copying, exactly the rectangle is uploaded.
+
+Otherwise, `glTexSubImage2D` is called directly. If the rectangle spans
+full rows of the image, they are read from client memory; otherwise,
+the rectangle is packed into `staging_` first (without
+`GL_UNPACK_ROW_LENGTH`, which OpenGL ES 2 lacks, a sub-rectangle can't
+be read from client memory).
+
+All methods, including ctor and dtor, must be called with an OpenGL
+context current.
+*/
+
+class TextureUploader
+{
+public:
+  explicit TextureUploader(int num_buffers = 3);
+  ~TextureUploader();
+
+  TextureUploader(const TextureUploader&) = delete;
+  TextureUploader& operator=(const TextureUploader&) = delete;
+
+  // Check if pixel buffer objects are used.
+  bool isStreaming() const;
+
+  // Upload the rectangle `rect` of the image `data` into the texture
+  // currently bound to `GL_TEXTURE_2D`, such that the pixel `(x, y)` of
+  // the image is written to the texel `(x, y) - origin`. The image has
+  // rows of `width` pixels of `bytes_per_pixel` bytes each. `format`
+  // and `type` are passed on to `glTexSubImage2D`.
+  void upload(
+      const QRect& rect,
+      const void* data,
+      int width,
+      int bytes_per_pixel,
+      GLenum format,
+      GLenum type,
+      const QPoint& origin = {}
+    );
+
+private:
+  void uploadDirect(const QRect&, const void*, int, int, GLenum, GLenum, const QPoint&);
+  bool uploadStreaming(const QRect&, const void*, int, int, GLenum, GLenum, const QPoint&);
+
+  // Copy the rectangle `rect` of the image `data` to `target`.
+  static void pack(const QRect& rect, const void* data, int width, int bytes_per_pixel, char* target);
+
+  std::vector<QOpenGLBuffer> buffers_{};
+  std::vector<char> staging_{};
+  std::size_t next_ = 0;
+};
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_DETAIL_TEXTUREUPLOADER_H */
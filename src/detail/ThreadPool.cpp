@@ -0,0 +1,132 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "ThreadPool.h"
+
+#include <stdexcept>
+
+namespace drautomaton {
+
+ThreadPool::ThreadPool(std::size_t num_threads)
+{
+  if (num_threads == 0)
+  {
+    throw std::runtime_error{"ThreadPool requires at least one thread"};
+  }
+
+  threads_.reserve(num_threads);
+  try
+  {
+    for (std::size_t i = 0; i < num_threads; ++i)
+    {
+      threads_.emplace_back(&ThreadPool::work, this, i);
+    }
+  }
+  catch (...)
+  {
+    // Destroying a joinable thread terminates the program.
+    stop();
+    throw;
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  stop();
+}
+
+std::size_t
+ThreadPool::size() const
+{
+  return threads_.size();
+}
+
+void
+ThreadPool::dispatch(Task task, void* context)
+{
+  std::lock_guard<std::mutex> run_lock{run_mutex_};
+  std::unique_lock<std::mutex> lock{mutex_};
+  task_ = task;
+  context_ = context;
+  pending_ = threads_.size();
+  ++generation_;
+  start_.notify_all();
+  done_.wait(lock, [this] () { return pending_ == 0; });
+
+  if (error_)
+  {
+    auto error = std::move(error_);
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void
+ThreadPool::work(std::size_t index)
+{
+  std::uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true)
+  {
+    start_.wait(lock, [&] () { return quit_ or generation_ != seen; });
+    if (quit_)
+    {
+      return;
+    }
+    seen = generation_;
+    auto task = task_;
+    auto context = context_;
+
+    lock.unlock();
+    std::exception_ptr error{};
+    try
+    {
+      task(context, index);
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+    lock.lock();
+
+    if (error and not error_)
+    {
+      error_ = std::move(error);
+    }
+    if (--pending_ == 0)
+    {
+      done_.notify_one();
+    }
+  }
+}
+
+void
+ThreadPool::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    quit_ = true;
+  }
+  start_.notify_all();
+  for (auto& thread : threads_)
+  {
+    thread.join();
+  }
+}
+
+} // namespace drautomaton
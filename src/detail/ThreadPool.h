@@ -0,0 +1,97 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_THREADPOOL_H
+#define DRAUTOMATON_SRC_DETAIL_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace drautomaton {
+
+/* ThreadPool
+
+Fixed set of worker threads which execute one task each per call of
+`run`. The threads are created by the ctor and joined by the dtor, so
+that `run` neither creates threads nor allocates memory.
+
+Task `i` is always executed by worker `i`, so that data owned by a task
+stays with the same thread across calls.
+
+Concurrent calls of `run` are serialized.
+*/
+
+class ThreadPool
+{
+public:
+  explicit ThreadPool(std::size_t num_threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  std::size_t size() const;
+
+  // Call `f(i)` on worker `i` for every `i` in `[0, size())` and block
+  // until all calls have returned. If any call throws, the first
+  // exception is rethrown after all calls have returned.
+  template<typename F>
+  void run(F&& f);
+
+private:
+  using Task = void (*)(void*, std::size_t);
+
+  void dispatch(Task, void*);
+  void work(std::size_t);
+
+  // Tell the workers to quit and join them.
+  void stop();
+
+  std::mutex run_mutex_{};
+  std::mutex mutex_{};
+  std::condition_variable start_{};
+  std::condition_variable done_{};
+  std::uint64_t generation_ = 0;
+  std::size_t pending_ = 0;
+  bool quit_ = false;
+  Task task_ = nullptr;
+  void* context_ = nullptr;
+  std::exception_ptr error_{};
+  std::vector<std::thread> threads_{};
+};
+
+template<typename F>
+void
+ThreadPool::run(F&& f)
+{
+  using Functor = std::remove_reference_t<F>;
+  dispatch(
+      [] (void* context, std::size_t i) { (*static_cast<Functor*>(context))(i); },
+      const_cast<void*>(static_cast<const void*>(std::addressof(f)))
+    );
+}
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_DETAIL_THREADPOOL_H */
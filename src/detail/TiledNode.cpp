@@ -0,0 +1,348 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "TiledNode.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <memory>
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QSGTextureMaterial>
+
+#include "IndexedNode.h"
+#include "TextureUploader.h"
+#include "Utility.h"
+
+namespace drautomaton {
+
+namespace {
+
+// Geometry node which displays a texture it owns, and streams the
+// updates of the texture.
+class TextureTile : public QSGGeometryNode
+{
+public:
+  explicit TextureTile(QSGTexture* texture)
+  :
+    texture_{texture}
+  {
+    auto material = new QSGTextureMaterial{};
+    material->setTexture(texture);
+
+    // The magnification filter will be used to magnify each texel
+    // (cell). When doing so, we don't want sharp edges, so we're using
+    // nearest neighbor filtering.
+    material->setFiltering(QSGTexture::Nearest);
+
+    // See `IndexedNode`.
+    setGeometry(new QSGGeometry{QSGGeometry::defaultAttributes_TexturedPoint2D(), 0});
+    setMaterial(material);
+    setFlags(QSGNode::OwnsGeometry | QSGNode::OwnsMaterial);
+  }
+
+  QSGTexture*
+  texture() const
+  {
+    return texture_.get();
+  }
+
+  TextureUploader uploader{};
+
+private:
+  std::unique_ptr<QSGTexture> texture_;
+};
+
+} // namespace
+
+TiledNode::TiledNode(int width, int height, int tile_size)
+:
+  width_{width},
+  height_{height},
+  tile_size_{tile_size}
+{
+  if (width < 1 or height < 1 or tile_size < 1)
+  {
+    throw std::runtime_error{"invalid TiledNode dimensions"};
+  }
+  columns_ = (width_ + tile_size_ - 1) / tile_size_;
+  rows_ = (height_ + tile_size_ - 1) / tile_size_;
+  tiles_.resize(columns_ * rows_, nullptr);
+}
+
+int
+TiledNode::width() const
+{
+  return width_;
+}
+
+int
+TiledNode::height() const
+{
+  return height_;
+}
+
+void
+TiledNode::setRect(const QRectF& rect)
+{
+  if (rect == rect_)
+  {
+    return;
+  }
+
+  rect_ = rect;
+  placeAll();
+}
+
+void
+TiledNode::setOrigin(const QPoint& origin)
+{
+  if (origin == origin_)
+  {
+    return;
+  }
+
+  origin_ = origin;
+  placeAll();
+}
+
+void
+TiledNode::update(const QRect& visible, const QRegion& dirty)
+{
+  for (int row = 0; row < rows_; ++row)
+  {
+    for (int column = 0; column < columns_; ++column)
+    {
+      auto& node = tiles_[row * columns_ + column];
+      auto rect = tile(column, row);
+      bool is_visible = false;
+      for (const auto& part : wrap(rect, -origin_, {width_, height_}))
+      {
+        is_visible = is_visible or part.intersects(visible);
+      }
+
+      if (not is_visible)
+      {
+        if (node)
+        {
+          removeChildNode(node);
+          delete node;
+          node = nullptr;
+        }
+      }
+      else if (not node)
+      {
+        node = createTile(rect);
+        place(node, rect);
+        uploadTile(node, rect, rect);
+        appendChildNode(node);
+      }
+      else
+      {
+        for (const auto& changed : dirty)
+        {
+          if (rect.intersects(changed))
+          {
+            uploadTile(node, rect, rect & changed);
+          }
+        }
+      }
+    }
+  }
+}
+
+int
+TiledNode::defaultTileSize()
+{
+  GLint max_size = 0;
+  QOpenGLContext::currentContext()->functions()->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+  return std::clamp(static_cast<int>(max_size), 64, 2048);
+}
+
+std::array<QRect, 4>
+TiledNode::wrap(const QRect& rect, const QPoint& offset, const QSize& size)
+{
+  int x = detail::mod(rect.x() + offset.x(), size.width());
+  int y = detail::mod(rect.y() + offset.y(), size.height());
+  int left = std::min(rect.width(), size.width() - x);  // Width of the left parts.
+  int top = std::min(rect.height(), size.height() - y);  // Height of the top parts.
+  return {{
+      QRect{x, y, left, top},
+      QRect{0, y, rect.width() - left, top},
+      QRect{x, 0, left, rect.height() - top},
+      QRect{0, 0, rect.width() - left, rect.height() - top}
+    }};
+}
+
+QRect
+TiledNode::tile(int column, int row) const
+{
+  return QRect{column * tile_size_, row * tile_size_, tile_size_, tile_size_}
+      & QRect{0, 0, width_, height_};
+}
+
+QRectF
+TiledNode::area(const QRect& rect) const
+{
+  qreal scale_x = rect_.width() / width_;
+  qreal scale_y = rect_.height() / height_;
+  return {
+      rect_.x() + rect.x() * scale_x,
+      rect_.y() + rect.y() * scale_y,
+      rect.width() * scale_x,
+      rect.height() * scale_y
+    };
+}
+
+void
+TiledNode::place(QSGGeometryNode* node, const QRect& tile)
+{
+  // Draw every part of the tile as a quad of two triangles, whose
+  // texture coordinates select the corresponding part of the texture.
+  auto parts = wrap(tile, -origin_, {width_, height_});
+  int count = 0;
+  for (const auto& part : parts)
+  {
+    count += part.isEmpty() ? 0 : 1;
+  }
+
+  auto geometry = node->geometry();
+  if (geometry->vertexCount() != 6 * count)
+  {
+    geometry->allocate(6 * count);
+  }
+  geometry->setDrawingMode(QSGGeometry::DrawTriangles);
+  auto vertex = geometry->vertexDataAsTexturedPoint2D();
+  for (int i = 0; i < 4; ++i)
+  {
+    const auto& part = parts[i];
+    if (part.isEmpty())
+    {
+      continue;
+    }
+
+    auto quad = area(part);
+    float left = static_cast<float>((i & 1) ? parts[0].width() : 0) / tile.width();
+    float top = static_cast<float>((i & 2) ? parts[0].height() : 0) / tile.height();
+    float right = left + static_cast<float>(part.width()) / tile.width();
+    float bottom = top + static_cast<float>(part.height()) / tile.height();
+    vertex[0].set(quad.left(), quad.top(), left, top);
+    vertex[1].set(quad.right(), quad.top(), right, top);
+    vertex[2].set(quad.left(), quad.bottom(), left, bottom);
+    vertex[3].set(quad.right(), quad.top(), right, top);
+    vertex[4].set(quad.right(), quad.bottom(), right, bottom);
+    vertex[5].set(quad.left(), quad.bottom(), left, bottom);
+    vertex += 6;
+  }
+  node->markDirty(QSGNode::DirtyGeometry);
+}
+
+void
+TiledNode::placeAll()
+{
+  for (int row = 0; row < rows_; ++row)
+  {
+    for (int column = 0; column < columns_; ++column)
+    {
+      if (auto node = tiles_[row * columns_ + column])
+      {
+        place(node, tile(column, row));
+      }
+    }
+  }
+}
+
+TiledTextureNode::TiledTextureNode(QQuickWindow* window, int width, int height, int tile_size)
+:
+  TiledNode{width, height, tile_size},
+  window_{window}
+{}
+
+void
+TiledTextureNode::setSource(const Color* pixels)
+{
+  source_ = pixels;
+}
+
+QSGGeometryNode*
+TiledTextureNode::createTile(const QRect& tile)
+{
+  return new TextureTile{window_->createTextureFromImage(
+      QImage{tile.size(), QImage::Format_ARGB32}
+    )};
+}
+
+void
+TiledTextureNode::uploadTile(QSGGeometryNode* node, const QRect& tile, const QRect& rect)
+{
+  auto texture_tile = static_cast<TextureTile*>(node);
+  texture_tile->texture()->bind();
+  texture_tile->uploader.upload(
+      rect,
+      source_,
+      width(),
+      sizeof(Color),
+      GL_BGRA,
+      GL_UNSIGNED_INT_8_8_8_8_REV,  // REV to convert Qt's ARGB to BGRA.
+      tile.topLeft()
+    );
+  texture_tile->markDirty(QSGNode::DirtyMaterial);
+}
+
+TiledIndexedNode::TiledIndexedNode(int width, int height, int tile_size)
+:
+  TiledNode{width, height, tile_size}
+{}
+
+void
+TiledIndexedNode::setSource(const std::uint8_t* indices)
+{
+  source_ = indices;
+}
+
+void
+TiledIndexedNode::setPalette(const Palette& palette)
+{
+  palette_ = palette;
+  for (auto node = firstChild(); node; node = node->nextSibling())
+  {
+    auto tile = static_cast<IndexedNode*>(node);
+    tile->indexedMaterial()->uploadPalette(palette_);
+    tile->markDirty(QSGNode::DirtyMaterial);
+  }
+}
+
+QSGGeometryNode*
+TiledIndexedNode::createTile(const QRect& tile)
+{
+  auto node = new IndexedNode{tile.width(), tile.height()};
+  node->indexedMaterial()->uploadPalette(palette_);
+  return node;
+}
+
+void
+TiledIndexedNode::uploadTile(QSGGeometryNode* node, const QRect& tile, const QRect& rect)
+{
+  auto indexed_tile = static_cast<IndexedNode*>(node);
+  indexed_tile->indexedMaterial()->uploadIndices(rect, source_, width(), tile.topLeft());
+  indexed_tile->markDirty(QSGNode::DirtyMaterial);
+}
+
+} // namespace drautomaton
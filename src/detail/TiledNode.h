@@ -0,0 +1,177 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_TILEDNODE_H
+#define DRAUTOMATON_SRC_DETAIL_TILEDNODE_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <QQuickWindow>
+#include <QRect>
+#include <QRegion>
+#include <QSGGeometryNode>
+
+#include "Color.h"
+#include "Palette.h"
+
+namespace drautomaton {
+
+/* TiledNode
+
+Scene graph node which displays an image of `width() * height()` pixels
+as a grid of child nodes, the _tiles_, each of which holds a texture of
+at most `tile_size` x `tile_size` texels. This allows displaying images
+larger than `GL_MAX_TEXTURE_SIZE`.
+
+The source image is wrap-addressed (see `IModel`): The pixel `(x, y)`
+of the displayed image is the pixel `(x, y) + origin()` of the source
+image, modulo its size. The textures hold the source image, so moving
+the origin only changes the geometry: Every tile is drawn as up to four
+quads, split at the seams of the source image.
+
+Only the tiles which intersect the visible part of the image are kept
+in GPU memory: `update` creates (_pages in_) the tiles which became
+visible and uploads them in full, destroys (_pages out_) the tiles
+which are no longer visible, and uploads the changed rectangles into
+the remaining tiles.
+
+The tiles are geometry nodes with `QSGGeometry::TexturedPoint2D`
+vertices. The texture format is implemented by the subclasses. All
+methods must be called with an OpenGL context current (for example,
+from `QQuickItem::updatePaintNode`).
+*/
+
+class TiledNode : public QSGNode
+{
+public:
+  TiledNode(int width, int height, int tile_size);
+
+  int width() const;
+  int height() const;
+
+  // Set the rectangle (in item coordinates) covered by the image.
+  void setRect(const QRectF&);
+
+  // Set the position in the source image of the top-left pixel of the
+  // displayed image. Default is `(0, 0)`.
+  void setOrigin(const QPoint&);
+
+  // Page the tiles in and out according to `visible` (in pixels of the
+  // displayed image), and upload the region `dirty` (in pixels of the
+  // source image).
+  void update(const QRect& visible, const QRegion& dirty);
+
+  // Return the largest tile size supported by the current context, but
+  // no more than 2048.
+  static int defaultTileSize();
+
+  // Translate `rect` by `offset` on a torus of the specified `size`,
+  // which must be large enough to hold `rect`. Return the parts of the
+  // result which lie on either side of the edges of the torus, ordered
+  // like the parts of `rect` they stem from: top-left, top-right,
+  // bottom-left, bottom-right. Parts which don't exist are empty.
+  static std::array<QRect, 4> wrap(const QRect& rect, const QPoint& offset, const QSize& size);
+
+protected:
+  // Create the node of a tile covering the rectangle `tile` of the
+  // image.
+  virtual QSGGeometryNode* createTile(const QRect& tile) = 0;
+
+  // Upload the rectangle `rect` of the image into the tile `node`,
+  // which covers `tile`.
+  virtual void uploadTile(QSGGeometryNode* node, const QRect& tile, const QRect& rect) = 0;
+
+private:
+  // Return the rectangle of the source image covered by a tile, or the
+  // rectangle of the item covered by the pixels `rect` of the displayed
+  // image.
+  QRect tile(int column, int row) const;
+  QRectF area(const QRect& rect) const;
+
+  // Set the geometry of the tile `node`, which covers `tile`.
+  void place(QSGGeometryNode* node, const QRect& tile);
+
+  // Call `place` for every tile which is paged in.
+  void placeAll();
+
+  int width_;
+  int height_;
+  int tile_size_;
+  int columns_;
+  int rows_;
+  QRectF rect_{};
+  QPoint origin_{};
+  std::vector<QSGGeometryNode*> tiles_;  // Null if paged out.
+};
+
+/* TiledTextureNode
+
+Tiled node which displays an image of `Color`s.
+*/
+
+class TiledTextureNode : public TiledNode
+{
+public:
+  TiledTextureNode(QQuickWindow* window, int width, int height, int tile_size);
+
+  // Set the image to display, which must hold `width() * height()`
+  // colors, row-by-row, and remain valid during `update`.
+  void setSource(const Color* pixels);
+
+protected:
+  QSGGeometryNode* createTile(const QRect& tile) override;
+  void uploadTile(QSGGeometryNode* node, const QRect& tile, const QRect& rect) override;
+
+private:
+  QQuickWindow* window_;
+  const Color* source_ = nullptr;
+};
+
+/* TiledIndexedNode
+
+Tiled node which displays an image of palette indices, colorized on the
+GPU by `IndexedMaterial`s.
+*/
+
+class TiledIndexedNode : public TiledNode
+{
+public:
+  TiledIndexedNode(int width, int height, int tile_size);
+
+  // Set the image to display, which must hold `width() * height()`
+  // indices, row-by-row, and remain valid during `update`.
+  void setSource(const std::uint8_t* indices);
+
+  // Upload the palette to all tiles (including the ones paged in
+  // later).
+  void setPalette(const Palette&);
+
+protected:
+  QSGGeometryNode* createTile(const QRect& tile) override;
+  void uploadTile(QSGGeometryNode* node, const QRect& tile, const QRect& rect) override;
+
+private:
+  const std::uint8_t* source_ = nullptr;
+  Palette palette_{};
+};
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_DETAIL_TILEDNODE_H */
@@ -0,0 +1,123 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DRAUTOMATON_SRC_DETAIL_TRIPLEBUFFER_H
+#define DRAUTOMATON_SRC_DETAIL_TRIPLEBUFFER_H
+
+#include <array>
+#include <atomic>
+
+namespace drautomaton {
+
+/* TripleBuffer
+
+Lock-free single-producer/single-consumer exchange of values of type
+`T`. The writer fills `back()` and calls `publish()`; the reader calls
+`update()` to acquire the most recently published value as `front()`.
+Neither side ever blocks or waits for the other, and values published
+while the reader is busy are skipped.
+
+*** Implementation details ***
+
+* The three slots are owned by the writer (`back_`), the reader
+  (`front_`) and neither (`middle_`). Publishing and acquiring swap the
+  own slot with the middle one. The `fresh` bit of `middle_` is set if
+  the middle slot holds a value the reader hasn't seen yet.
+*/
+
+template<typename T>
+class TripleBuffer
+{
+public:
+  // Writer.
+  T& back();
+  void publish();
+
+  // Reader. Return `true` if a new value was acquired.
+  bool update();
+  T& front();
+  const T& front() const;
+
+  // Call `f` on all three slots. Not thread-safe; the caller must make
+  // sure that neither the writer nor the reader is active.
+  template<typename F>
+  void forEach(F&& f);
+
+private:
+  static constexpr unsigned fresh = 4;
+
+  std::array<T, 3> slots_{};
+  unsigned back_ = 0;
+  std::atomic<unsigned> middle_{1};
+  unsigned front_ = 2;
+};
+
+template<typename T>
+T&
+TripleBuffer<T>::back()
+{
+  return slots_[back_];
+}
+
+template<typename T>
+void
+TripleBuffer<T>::publish()
+{
+  back_ = middle_.exchange(back_ | fresh, std::memory_order_acq_rel) & ~fresh;
+}
+
+template<typename T>
+bool
+TripleBuffer<T>::update()
+{
+  if (not (middle_.load(std::memory_order_relaxed) & fresh))
+  {
+    return false;
+  }
+  front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~fresh;
+  return true;
+}
+
+template<typename T>
+T&
+TripleBuffer<T>::front()
+{
+  return slots_[front_];
+}
+
+template<typename T>
+const T&
+TripleBuffer<T>::front() const
+{
+  return slots_[front_];
+}
+
+template<typename T>
+template<typename F>
+void
+TripleBuffer<T>::forEach(F&& f)
+{
+  for (auto& slot : slots_)
+  {
+    f(slot);
+  }
+}
+
+} // namespace drautomaton
+
+#endif /* DRAUTOMATON_SRC_DETAIL_TRIPLEBUFFER_H */
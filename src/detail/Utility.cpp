@@ -18,6 +18,9 @@
 
 #include "Utility.h"
 
+#include <algorithm>
+#include <cstdlib>
+
 namespace drautomaton { namespace detail {
 
 int
@@ -31,4 +34,38 @@ mod(int x, int y)
   return r;
 }
 
+std::vector<QPoint>
+line(const QPoint& from, const QPoint& to)
+{
+  int dx = std::abs(to.x() - from.x());
+  int dy = -std::abs(to.y() - from.y());
+  int sx = from.x() < to.x() ? 1 : -1;
+  int sy = from.y() < to.y() ? 1 : -1;
+
+  std::vector<QPoint> result{};
+  result.reserve(std::max(dx, -dy) + 1);
+  int x = from.x();
+  int y = from.y();
+  int error = dx + dy;
+  while (true)
+  {
+    result.emplace_back(x, y);
+    if (x == to.x() and y == to.y())
+    {
+      return result;
+    }
+    int twice = 2 * error;
+    if (twice >= dy)
+    {
+      error += dy;
+      x += sx;
+    }
+    if (twice <= dx)
+    {
+      error += dx;
+      y += sy;
+    }
+  }
+}
+
 }} // namespace drautomaton::detail
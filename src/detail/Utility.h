@@ -19,11 +19,40 @@
 #ifndef DRAUTOMATON_SRC_DETAIL_UTILITY_H
 #define DRAUTOMATON_SRC_DETAIL_UTILITY_H
 
+#include <cstdint>
+#include <vector>
+
+#include <QPoint>
+
 namespace drautomaton { namespace detail {
 
 // Return x (mod) y. Example: `mod(-1, 10)` equals `9`.
 int mod(int x, int y);
 
+// Return the cells of the (8-connected) line from `from` to `to`, both
+// included, computed by Bresenham's algorithm.
+std::vector<QPoint> line(const QPoint& from, const QPoint& to);
+
+// Return the 64-bit finalizer of SplitMix64 applied to `z`.
+inline std::uint64_t
+mix(std::uint64_t z)
+{
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+// Return the Zobrist key of the cell `(x, y)` in state `state`. Instead
+// of a table of random keys, the keys are computed by mixing the
+// arguments.
+inline std::uint64_t
+zobrist(int x, int y, int state)
+{
+  auto position = static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32
+      | static_cast<std::uint32_t>(y);
+  return mix(mix(position) + static_cast<std::uint32_t>(state));
+}
+
 }} // namespace drautomaton::detail
 
 #endif /* DRAUTOMATON_SRC_DETAIL_UTILITY_H */
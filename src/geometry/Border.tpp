@@ -27,7 +27,7 @@ Border<T>::cell(
     int y,
     int width,
     int height,
-    const std::vector<std::vector<T>>& data
+    const std::vector<Column<T>>& data
   ) const
 {
   int u = detail::mod(x, width);
@@ -45,6 +45,13 @@ Border<T>::cell(
   }
 }
 
+template<typename T>
+bool
+Border<T>::preservesColumns() const
+{
+  return true;
+}
+
 template<typename T>
 void
 Border<T>::setDefault(T def)
@@ -39,7 +39,7 @@ public:
       int y,
       int width,
       int height,
-      const std::vector<std::vector<T>>& data
+      const std::vector<Column<T>>& data
     ) const override;
 };
 
@@ -27,7 +27,7 @@ Projective<T>::cell(
     int y,
     int width,
     int height,
-    const std::vector<std::vector<T>>& data
+    const std::vector<Column<T>>& data
   ) const
 {
   int s = std::abs(x / width);
@@ -27,7 +27,7 @@ Torus<T>::cell(
     int y,
     int width,
     int height,
-    const std::vector<std::vector<T>>& data
+    const std::vector<Column<T>>& data
   ) const
 {
   int u = x;
@@ -45,4 +45,11 @@ Torus<T>::cell(
   return data[u][v];
 }
 
+template<typename T>
+bool
+Torus<T>::preservesColumns() const
+{
+  return true;
+}
+
 }} // namespace drautomaton::geometry
@@ -27,7 +27,7 @@ WrapX<T>::cell(
     int y,
     int width,
     int height,
-    const std::vector<std::vector<T>>& data
+    const std::vector<Column<T>>& data
   ) const
 {
   if (y < 0 or y >= height)
@@ -43,6 +43,13 @@ WrapX<T>::cell(
   return data[x][y];
 }
 
+template<typename T>
+bool
+WrapX<T>::preservesColumns() const
+{
+  return true;
+}
+
 template<typename T>
 void
 WrapX<T>::setDefault(T def)
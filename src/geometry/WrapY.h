@@ -38,8 +38,9 @@ public:
       int y,
       int width,
       int height,
-      const std::vector<std::vector<T>>& data
+      const std::vector<Column<T>>& data
     ) const override;
+  bool preservesColumns() const override;
 
   void setDefault(T);
 
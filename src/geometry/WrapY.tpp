@@ -27,7 +27,7 @@ WrapY<T>::cell(
     int y,
     int width,
     int height,
-    const std::vector<std::vector<T>>& data
+    const std::vector<Column<T>>& data
   ) const
 {
   if (x < 0 or x >= width)
@@ -43,6 +43,13 @@ WrapY<T>::cell(
   return data[x][y];
 }
 
+template<typename T>
+bool
+WrapY<T>::preservesColumns() const
+{
+  return true;
+}
+
 template<typename T>
 void
 WrapY<T>::setDefault(T def)
@@ -19,6 +19,8 @@
 #ifndef DRAUTOMATON_SRC_RULES_CYCLIC_H
 #define DRAUTOMATON_SRC_RULES_CYCLIC_H
 
+#include "../Space.h"
+
 namespace drautomaton {
 
 /* CyclicState
@@ -0,0 +1,97 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <DrMock/Test.h>
+
+#define DRAUTO_PROFILING
+#include "detail/CountAllocations.h"
+#include "geometry/Border.h"
+#include "geometry/Torus.h"
+#include "rules/Brain.h"
+#include "rules/Cyclic.h"
+#include "rules/GameOfLife.h"
+#include "rules/SRLoop.h"
+#include "Cellular.h"
+
+using namespace drautomaton;
+
+namespace {
+
+// Return the number of allocations made by `Cellular::doUpdate` after
+// warm-up.
+template<typename Rule>
+std::uint64_t
+steadyStateAllocations(UpdateMode mode = UpdateMode::buffered)
+{
+  Cellular<Rule> cellular{64, 48, 4, mode};
+  cellular.setGeometry(std::make_shared<geometry::Torus<typename Rule::State>>());
+  for (int x = 0; x < 64; ++x)
+  {
+    cellular.increment(x, (x * 7) % 48);
+  }
+
+  // Warm-up.
+  for (int i = 0; i < 3; ++i)
+  {
+    cellular.doUpdate();
+  }
+  drprof::reset();
+
+  auto before = drprof::allocations();
+  for (int i = 0; i < 20; ++i)
+  {
+    cellular.doUpdate();
+  }
+  auto after = drprof::allocations();
+
+  // The per-phase accounting must agree with the global one.
+  DRTEST_ASSERT_EQ(drprof::getPasses("Cellular::doUpdate"), 20u);
+  DRTEST_ASSERT_EQ(
+      drprof::getAllocations("Cellular::doUpdate").count
+      + drprof::getAllocations("Cellular::processBlock").count,
+      after.count - before.count
+    );
+  return after.count - before.count;
+}
+
+} // namespace
+
+DRTEST_TEST(counting)
+{
+  auto before = drprof::threadAllocations();
+  {
+    DRPROF_SCOPE("Allocation::counting");
+    auto ptr = std::make_unique<std::uint64_t[]>(100);
+    ptr[0] = 1;
+  }
+  auto after = drprof::threadAllocations();
+
+  DRTEST_ASSERT(drprof::countingAllocations());
+  DRTEST_ASSERT_EQ(after.count - before.count, 1u);
+  DRTEST_ASSERT_LE(800u, after.bytes - before.bytes);
+  DRTEST_ASSERT_EQ(drprof::getAllocations("Allocation::counting").count, 1u);
+}
+
+DRTEST_TEST(steadyState)
+{
+  DRTEST_ASSERT_EQ(steadyStateAllocations<GameOfLife>(), 0u);
+  DRTEST_ASSERT_EQ(steadyStateAllocations<Brain>(), 0u);
+  DRTEST_ASSERT_EQ(steadyStateAllocations<Cyclic<16>>(), 0u);
+  DRTEST_ASSERT_EQ(steadyStateAllocations<SRLoop>(), 0u);
+  DRTEST_ASSERT_EQ(steadyStateAllocations<GameOfLife>(UpdateMode::inPlace), 0u);
+}
@@ -0,0 +1,172 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+
+#include <DrMock/Test.h>
+
+#include "geometry/Torus.h"
+#include "rules/GameOfLife.h"
+#include "Arena.h"
+#include "Cellular.h"
+
+using namespace drautomaton;
+
+DRTEST_TEST(allocate)
+{
+  for (auto pages : {Arena::Pages::normal, Arena::Pages::transparent, Arena::Pages::reserved})
+  {
+    Arena arena{pages};
+    DRTEST_ASSERT_EQ(arena.capacity(), 0u);
+
+    // Small blocks share a chunk and are aligned to cache lines.
+    std::vector<void*> blocks{};
+    for (std::size_t size : {1, 63, 64, 65, 1000})
+    {
+      auto ptr = arena.allocate(size, 1);
+      DRTEST_ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % Arena::alignment, 0u);
+      blocks.push_back(ptr);
+    }
+    DRTEST_ASSERT_EQ(arena.capacity(), Arena::huge_page_size);
+    DRTEST_ASSERT_LE(arena.reservedCapacity(), arena.capacity());
+
+    // Freed blocks are reused, except during a placement.
+    arena.deallocate(blocks[4], 1000, 1);
+    arena.beginPlacement();
+    auto fresh = arena.allocate(1000, 1);
+    DRTEST_ASSERT_NE(fresh, blocks[4]);
+    arena.endPlacement();
+    DRTEST_ASSERT_EQ(arena.allocate(1000, 1), blocks[4]);
+    arena.deallocate(fresh, 1000, 1);
+
+    // Large blocks get chunks of their own.
+    auto large = arena.allocate(3 * Arena::huge_page_size / 2, 8);
+    DRTEST_ASSERT_EQ(reinterpret_cast<std::uintptr_t>(large) % Arena::huge_page_size, 0u);
+    DRTEST_ASSERT_EQ(arena.capacity(), 4 * Arena::huge_page_size);
+    static_cast<char*>(large)[3 * Arena::huge_page_size / 2 - 1] = 1;
+    arena.deallocate(large, 3 * Arena::huge_page_size / 2, 8);
+    DRTEST_ASSERT_EQ(arena.capacity(), 2 * Arena::huge_page_size);
+  }
+}
+
+DRTEST_TEST(concurrent)
+{
+  Arena arena{};
+  std::vector<std::thread> threads{};
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back(
+        [&arena] ()
+        {
+          std::pmr::vector<int> values{&arena};
+          for (int i = 0; i < 10000; ++i)
+          {
+            values.push_back(i);
+          }
+          std::pmr::vector<std::pmr::vector<char>> columns{&arena};
+          for (int i = 0; i < 100; ++i)
+          {
+            columns.emplace_back(300, 'x');
+          }
+          DRTEST_ASSERT_EQ(values.back(), 9999);
+          DRTEST_ASSERT_EQ(columns[99][299], 'x');
+        }
+      );
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+}
+
+DRTEST_TEST(cellular)
+{
+  // A CA using an arena behaves like one using the default resource.
+  using State = GameOfLife::State;
+  Arena arena{};
+  for (auto mode : {UpdateMode::buffered, UpdateMode::inPlace})
+  {
+    Cellular<GameOfLife> expected{50, 40, 3, mode};
+    Cellular<GameOfLife> cellular{50, 40, 3, mode, &arena};
+    expected.setGeometry(std::make_shared<geometry::Torus<State>>());
+    cellular.setGeometry(std::make_shared<geometry::Torus<State>>());
+    for (int x = 0; x < 50; ++x)
+    {
+      DRTEST_ASSERT_EQ(reinterpret_cast<std::uintptr_t>(cellular.space().data()[x].data()) % Arena::alignment, 0u);
+      for (int y = 0; y < 40; ++y)
+      {
+        auto state = (x * y + x) % 3 == 0 ? State::live : State::dead;
+        expected.space().cell(x, y) = state;
+        cellular.space().cell(x, y) = state;
+      }
+    }
+    expected.rehash();
+    cellular.rehash();
+    for (int i = 0; i < 10; ++i)
+    {
+      expected.doUpdate();
+      cellular.doUpdate();
+      DRTEST_ASSERT_EQ(cellular.hash(), expected.hash());
+    }
+    DRTEST_ASSERT_LE(Arena::huge_page_size, arena.capacity());
+  }
+}
+
+DRTEST_TEST(placement)
+{
+  // The workers place copies of all columns in memory which the ctor
+  // didn't touch, so the arena holds the space twice.
+  using State = GameOfLife::State;
+  for (auto mode : {UpdateMode::buffered, UpdateMode::inPlace})
+  {
+    Arena arena{};
+    Cellular<GameOfLife> cellular{4096, 1024, 4, mode, &arena};
+    std::size_t bytes = std::size_t{4096} * 1024 * sizeof(State);
+    if (mode == UpdateMode::buffered)
+    {
+      bytes *= 2;  // tmp_
+    }
+    DRTEST_ASSERT_LE(2 * bytes, arena.capacity());
+
+    // Columns of different blocks never share a chunk.
+    auto checkChunks = [&cellular] ()
+      {
+        std::map<std::uintptr_t, int> owner{};
+        for (int x = 0; x < 4096; ++x)
+        {
+          auto chunk = reinterpret_cast<std::uintptr_t>(cellular.space().data()[x].data()) / Arena::huge_page_size;
+          auto block = x / 1024;
+          auto it = owner.emplace(chunk, block).first;
+          DRTEST_ASSERT_EQ(it->second, block);
+        }
+      };
+    checkChunks();
+
+    // Placing again doesn't reuse the columns freed by the first placement.
+    auto capacity = arena.capacity();
+    if (cellular.pinThreads())
+    {
+      DRTEST_ASSERT_LE(capacity + bytes, arena.capacity());
+      checkChunks();
+    }
+  }
+}
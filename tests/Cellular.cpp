@@ -16,11 +16,16 @@
  * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <thread>
+
 #include <QSignalSpy>
 
 #define DRTEST_USE_QT
 #include <DrMock/Test.h>
 
+#include "geometry/Projective.h"
+#include "geometry/Torus.h"
+#include "rules/GameOfLife.h"
 #include "Cellular.h"
 #include "Test.h"
 
@@ -71,6 +76,28 @@ DRTEST_TEST(doUpdate)
   }
 }
 
+DRTEST_TEST(changed)
+{
+  int width = Region::tile_size + 1;
+  int height = 2 * Region::tile_size;
+  auto cellular = std::make_shared<Cellular<Test>>(width, height);
+  DRTEST_ASSERT_EQ(cellular->changed().bounds(), QRect(0, 0, width, height));
+
+  // `Test` flips every cell.
+  cellular->doUpdate();
+  DRTEST_ASSERT_EQ(cellular->changed().bounds(), QRect(0, 0, width, height));
+
+  cellular->increment(Region::tile_size, Region::tile_size + 3);
+  DRTEST_ASSERT(not cellular->changed().isMarked(0, 0));
+  DRTEST_ASSERT(not cellular->changed().isMarked(0, 1));
+  DRTEST_ASSERT(not cellular->changed().isMarked(1, 0));
+  DRTEST_ASSERT(cellular->changed().isMarked(1, 1));
+  DRTEST_ASSERT_EQ(
+      cellular->changed().bounds(),
+      QRect(Region::tile_size, Region::tile_size, 1, Region::tile_size)
+    );
+}
+
 DRTEST_TEST(increment)
 {
   // Setup first generation.
@@ -108,3 +135,368 @@ DRTEST_TEST(increment)
   DRTEST_ASSERT_EQ(cellular->space().cell(3, 1), Test::State::live);
   DRTEST_ASSERT_EQ(cellular->space().cell(3, 2), Test::State::dead);
 }
+
+DRTEST_TEST(renderReduced)
+{
+  // 5x3 cells reduced by 2 -> 3x2 blocks, the last column and row of
+  // which are partial.
+  auto cellular = std::make_shared<Cellular<Test>>(5, 3);
+  cellular->space().fill(Test::State::dead);
+  cellular->space().cell(0, 0) = Test::State::live;  // Block (0, 0): 1/4.
+  cellular->space().cell(2, 0) = Test::State::live;  // Block (1, 0): 3/4.
+  cellular->space().cell(3, 0) = Test::State::live;
+  cellular->space().cell(3, 1) = Test::State::live;
+  cellular->space().cell(4, 2) = Test::State::live;  // Block (2, 1): 1/1.
+  Region region{5, 3};
+  region.fill();
+
+  std::vector<std::uint8_t> indices(6);
+  cellular->renderReducedIndices({0, 0, 5, 3}, 2, Reduction::majority, region, indices.data(), {});
+  DRTEST_ASSERT(indices == std::vector<std::uint8_t>({0, 1, 0, 0, 0, 1}));
+  cellular->renderReducedIndices({0, 0, 5, 3}, 2, Reduction::maximum, region, indices.data(), {});
+  DRTEST_ASSERT(indices == std::vector<std::uint8_t>({1, 1, 0, 0, 0, 1}));
+
+  Palette palette{};
+  palette.setColor(0, qRgb(0, 0, 0));
+  palette.setColor(1, qRgb(200, 100, 40));
+  std::vector<Color> pixels(6);
+  cellular->renderReduced({0, 0, 5, 3}, 2, Reduction::average, region, palette, pixels.data(), {});
+  DRTEST_ASSERT_EQ(pixels[0], qRgb(50, 25, 10));
+  DRTEST_ASSERT_EQ(pixels[1], qRgb(150, 75, 30));
+  DRTEST_ASSERT_EQ(pixels[3], qRgb(0, 0, 0));
+  DRTEST_ASSERT_EQ(pixels[5], qRgb(200, 100, 40));
+
+  // Only the blocks which intersect a marked tile are written.
+  Region none{5, 3};
+  std::fill(indices.begin(), indices.end(), 7);
+  cellular->renderReducedIndices({0, 0, 5, 3}, 2, Reduction::majority, none, indices.data(), {});
+  DRTEST_ASSERT(indices == std::vector<std::uint8_t>(6, 7));
+
+  DRTEST_ASSERT_THROW(
+      cellular->renderReducedIndices({0, 0, 5, 3}, 0, Reduction::majority, region, indices.data(), {}),
+      std::runtime_error
+    );
+}
+
+DRTEST_TEST(renderWrapped)
+{
+  auto cellular = std::make_shared<Cellular<Test>>(5, 3);
+  cellular->space().fill(Test::State::dead);
+  cellular->space().cell(1, 1) = Test::State::live;
+  cellular->space().cell(4, 2) = Test::State::live;
+  Region region{5, 3};
+  region.fill();
+
+  // The cells (1, 1) to (4, 2) are written to the pixels starting at
+  // (2, 1), wrapping around at the right edge.
+  std::vector<std::uint8_t> indices(8);
+  cellular->renderIndices({1, 1, 4, 2}, region, indices.data(), {2, 1});
+  DRTEST_ASSERT(indices == std::vector<std::uint8_t>({0, 1, 0, 0, 0, 0, 1, 0}));
+
+  // Negative origins wrap around as well.
+  std::vector<std::uint8_t> blocks(6);
+  cellular->renderReducedIndices({0, 0, 5, 3}, 2, Reduction::maximum, region, blocks.data(), {-1, 0});
+  DRTEST_ASSERT(blocks == std::vector<std::uint8_t>({0, 0, 1, 0, 1, 0}));
+}
+
+DRTEST_TEST(cycles)
+{
+  using State = GameOfLife::State;
+  auto cellular = std::make_shared<Cellular<GameOfLife>>(16, 12, 2);
+  cellular->setGeometry(std::make_shared<geometry::Torus<State>>());
+  QSignalSpy detected{cellular.get(), &CellularQObject::cycleDetected};
+
+  // Blinker.
+  cellular->space().cell(4, 5) = State::live;
+  cellular->space().cell(5, 5) = State::live;
+  cellular->space().cell(6, 5) = State::live;
+  cellular->rehash();
+  auto hash = cellular->hash();
+
+  cellular->doUpdate();
+  DRTEST_ASSERT_EQ(cellular->period(), 0);
+  DRTEST_ASSERT_NE(cellular->hash(), hash);
+  cellular->doUpdate();
+  DRTEST_ASSERT_EQ(cellular->period(), 2);
+  DRTEST_ASSERT_EQ(cellular->hash(), hash);
+  cellular->doUpdate();
+  DRTEST_ASSERT_EQ(cellular->period(), 2);
+  DRTEST_ASSERT_EQ(detected.size(), 1);
+  DRTEST_ASSERT_EQ(detected.at(0).at(0).toInt(), 2);
+
+  // The incremental hash agrees with the full one.
+  hash = cellular->hash();
+  cellular->rehash();
+  DRTEST_ASSERT_EQ(cellular->hash(), hash);
+  DRTEST_ASSERT_EQ(cellular->period(), 0);
+
+  // Turn the (vertical) blinker into a block.
+  cellular->increment(5, 4);
+  cellular->increment(6, 5);
+  cellular->increment(6, 6);
+  cellular->doUpdate();
+  DRTEST_ASSERT_EQ(cellular->period(), 1);
+  DRTEST_ASSERT_EQ(detected.size(), 2);
+
+  hash = cellular->hash();
+  cellular->rehash();
+  DRTEST_ASSERT_EQ(cellular->hash(), hash);
+}
+
+DRTEST_TEST(statistics)
+{
+  using State = GameOfLife::State;
+  auto cellular = std::make_shared<Cellular<GameOfLife>>(40, 36, 3);
+  cellular->setGeometry(std::make_shared<geometry::Torus<State>>());
+  DRTEST_ASSERT(not cellular->statisticsEnabled());
+
+  // Glider.
+  cellular->increment(1, 0);
+  cellular->increment(2, 1);
+  cellular->increment(0, 2);
+  cellular->increment(1, 2);
+  cellular->increment(2, 2);
+  cellular->setStatisticsEnabled(true);
+  DRTEST_ASSERT_EQ(cellular->statistics().population(), 5u);
+  DRTEST_ASSERT_EQ(cellular->statistics().histogram[0], 40u * 36u - 5u);
+
+  // A glider changes 4 cells per generation.
+  for (int i = 0; i < 10; ++i)
+  {
+    cellular->doUpdate();
+    DRTEST_ASSERT_EQ(cellular->statistics().population(), 5u);
+    DRTEST_ASSERT_EQ(cellular->statistics().changed, 4u);
+  }
+
+  cellular->increment(20, 20);
+  DRTEST_ASSERT_EQ(cellular->statistics().population(), 6u);
+  DRTEST_ASSERT_EQ(cellular->statistics().changed, 1u);
+
+  cellular->setStatisticsEnabled(false);
+  cellular->doUpdate();
+  DRTEST_ASSERT_EQ(cellular->statistics().population(), 0u);
+}
+
+DRTEST_TEST(batchEdits)
+{
+  using State = GameOfLife::State;
+  int size = 2 * Region::tile_size;
+  auto cellular = std::make_shared<Cellular<GameOfLife>>(size, size);
+  cellular->setStatisticsEnabled(true);
+  QSignalSpy updated{cellular.get(), &CellularQObject::updated};
+
+  // Each batch emits `updated` exactly once.
+  cellular->incrementCells({{0, 0}, {1, 0}, {1, 0}, {Region::tile_size, 0}});
+  DRTEST_ASSERT_EQ(updated.size(), 1);
+  DRTEST_ASSERT_EQ(cellular->space().cell(0, 0), State::live);
+  DRTEST_ASSERT_EQ(cellular->space().cell(1, 0), State::dead);  // x2
+  DRTEST_ASSERT_EQ(cellular->space().cell(Region::tile_size, 0), State::live);
+  DRTEST_ASSERT(cellular->changed().isMarked(0, 0));
+  DRTEST_ASSERT(cellular->changed().isMarked(1, 0));
+  DRTEST_ASSERT(not cellular->changed().isMarked(0, 1));
+  DRTEST_ASSERT_EQ(cellular->statistics().population(), 2u);
+
+  cellular->setCells({{5, Region::tile_size}, {6, Region::tile_size}}, State::live);
+  DRTEST_ASSERT_EQ(updated.size(), 2);
+  DRTEST_ASSERT_EQ(cellular->space().cell(6, Region::tile_size), State::live);
+  DRTEST_ASSERT(cellular->changed().isMarked(0, 1));
+  DRTEST_ASSERT(not cellular->changed().isMarked(0, 0));
+  DRTEST_ASSERT_EQ(cellular->statistics().population(), 4u);
+  DRTEST_ASSERT_EQ(cellular->statistics().changed, 2u);
+
+  cellular->fillRect(QRect{2, 2, 3, 4}, State::live);
+  DRTEST_ASSERT_EQ(updated.size(), 3);
+  DRTEST_ASSERT_EQ(cellular->space().cell(4, 5), State::live);
+  DRTEST_ASSERT_EQ(cellular->space().cell(5, 5), State::dead);
+  DRTEST_ASSERT_EQ(cellular->statistics().population(), 16u);
+
+  // The incrementally updated hash matches a full rehash.
+  auto hash = cellular->hash();
+  cellular->rehash();
+  DRTEST_ASSERT_EQ(cellular->hash(), hash);
+
+  // Out-of-bounds edits are rejected without touching the space.
+  DRTEST_ASSERT_THROW(cellular->incrementCells({{0, 0}, {size, 0}}), std::runtime_error);
+  DRTEST_ASSERT_THROW(cellular->setCells({{-1, 0}}, State::live), std::runtime_error);
+  DRTEST_ASSERT_THROW(cellular->fillRect(QRect{1, 1, size, 1}, State::live), std::runtime_error);
+  DRTEST_ASSERT_EQ(cellular->space().cell(0, 0), State::live);
+  DRTEST_ASSERT_EQ(updated.size(), 3);
+}
+
+DRTEST_TEST(queueIncrement)
+{
+  using State = GameOfLife::State;
+  auto cellular = std::make_shared<Cellular<GameOfLife>>(16, 12, 2);
+  cellular->setGeometry(std::make_shared<geometry::Torus<State>>());
+  QSignalSpy updated{cellular.get(), &CellularQObject::updated};
+
+  // Queued increments are applied before the next generation is
+  // computed: The horizontal blinker becomes a vertical one.
+  std::thread producer{
+      [&] ()
+      {
+        cellular->queueIncrement(4, 5);
+        cellular->queueIncrement(5, 5);
+        cellular->queueIncrement(6, 5);
+      }
+    };
+  producer.join();
+  DRTEST_ASSERT_EQ(cellular->space().cell(5, 5), State::dead);
+  cellular->doUpdate();
+  DRTEST_ASSERT_EQ(updated.size(), 1);
+  DRTEST_ASSERT_EQ(cellular->space().cell(5, 4), State::live);
+  DRTEST_ASSERT_EQ(cellular->space().cell(5, 5), State::live);
+  DRTEST_ASSERT_EQ(cellular->space().cell(5, 6), State::live);
+  DRTEST_ASSERT_EQ(cellular->space().cell(4, 5), State::dead);
+  auto hash = cellular->hash();
+  cellular->rehash();
+  DRTEST_ASSERT_EQ(cellular->hash(), hash);
+
+  // Or as one batch by `applyQueued`.
+  DRTEST_ASSERT(not cellular->applyQueued());
+  DRTEST_ASSERT_EQ(updated.size(), 1);
+  cellular->queueIncrement(0, 0);
+  cellular->queueIncrement(15, 11);
+  DRTEST_ASSERT(cellular->applyQueued());
+  DRTEST_ASSERT_EQ(updated.size(), 2);
+  DRTEST_ASSERT_EQ(cellular->space().cell(0, 0), State::live);
+  DRTEST_ASSERT_EQ(cellular->space().cell(15, 11), State::live);
+  DRTEST_ASSERT(cellular->changed().isMarked(0, 0));
+
+  DRTEST_ASSERT_THROW(cellular->queueIncrement(16, 0), std::runtime_error);
+  DRTEST_ASSERT_THROW(cellular->queueIncrement(0, -1), std::runtime_error);
+}
+
+DRTEST_TEST(queueIncrementConcurrent)
+{
+  // `Test` flips every cell in every generation, and so does every
+  // increment, so the outcome doesn't depend on when the increments
+  // are applied.
+  auto cellular = std::make_shared<Cellular<Test>>(40, 30, 3);
+  for (int x = 0; x < 40; ++x)
+  {
+    for (int y = 0; y < 30; ++y)
+    {
+      cellular->space().cell(x, y) = Test::State::dead;
+    }
+  }
+
+  std::thread producer{
+      [&] ()
+      {
+        for (int i = 0; i < 1001; ++i)
+        {
+          cellular->queueIncrement(7, 9);
+        }
+      }
+    };
+  for (int i = 0; i < 50; ++i)
+  {
+    cellular->doUpdate();
+  }
+  producer.join();
+  cellular->applyQueued();
+
+  DRTEST_ASSERT_EQ(cellular->space().cell(7, 9), Test::State::live);
+  DRTEST_ASSERT_EQ(cellular->space().cell(8, 9), Test::State::dead);
+}
+
+DRTEST_TEST(inPlace)
+{
+  using State = GameOfLife::State;
+
+  // The in-place update must agree with the buffered one for any
+  // partition of the columns, including empty and single-column blocks.
+  for (std::size_t num_threads : {1, 2, 3, 8})
+  {
+    for (int width : {5, 23, 40})
+    {
+      Cellular<GameOfLife> buffered{width, 17, num_threads};
+      Cellular<GameOfLife> in_place{width, 17, num_threads, UpdateMode::inPlace};
+      DRTEST_ASSERT(buffered.updateMode() == UpdateMode::buffered);
+      DRTEST_ASSERT(in_place.updateMode() == UpdateMode::inPlace);
+      buffered.setGeometry(std::make_shared<geometry::Torus<State>>());
+      in_place.setGeometry(std::make_shared<geometry::Torus<State>>());
+      buffered.setStatisticsEnabled(true);
+      in_place.setStatisticsEnabled(true);
+      for (int x = 0; x < width; ++x)
+      {
+        for (int y = 0; y < 17; ++y)
+        {
+          auto state = (x * x + 3 * y + x * y) % 7 < 3 ? State::live : State::dead;
+          buffered.space().cell(x, y) = state;
+          in_place.space().cell(x, y) = state;
+        }
+      }
+      buffered.rehash();
+      in_place.rehash();
+
+      for (int i = 0; i < 12; ++i)
+      {
+        buffered.doUpdate();
+        in_place.doUpdate();
+        for (int x = 0; x < width; ++x)
+        {
+          DRTEST_ASSERT(in_place.space().data()[x] == buffered.space().data()[x]);
+        }
+        DRTEST_ASSERT_EQ(in_place.hash(), buffered.hash());
+        DRTEST_ASSERT_EQ(in_place.changed().bounds(), buffered.changed().bounds());
+        DRTEST_ASSERT(in_place.statistics().histogram == buffered.statistics().histogram);
+        DRTEST_ASSERT_EQ(in_place.statistics().changed, buffered.statistics().changed);
+      }
+    }
+  }
+
+  // The projective plane glues non-adjacent columns.
+  Cellular<GameOfLife> in_place{8, 8, 2, UpdateMode::inPlace};
+  DRTEST_ASSERT_THROW(
+      in_place.setGeometry(std::make_shared<geometry::Projective<State>>()),
+      std::runtime_error
+    );
+  Cellular<GameOfLife> buffered{8, 8, 2};
+  buffered.setGeometry(std::make_shared<geometry::Projective<State>>());
+}
+
+DRTEST_TEST(placement)
+{
+  using State = GameOfLife::State;
+  for (auto mode : {UpdateMode::buffered, UpdateMode::inPlace})
+  {
+    Cellular<GameOfLife> cellular{64, 48, 3, mode};
+    cellular.setGeometry(std::make_shared<geometry::Torus<State>>());
+    cellular.space().cell(1, 0) = State::live;
+    cellular.space().cell(2, 1) = State::live;
+    cellular.space().cell(0, 2) = State::live;
+    cellular.space().cell(1, 2) = State::live;
+    cellular.space().cell(2, 2) = State::live;
+    cellular.rehash();
+
+    // Pinning may fail (for example, on other platforms), but must not
+    // change the CA.
+    auto hash = cellular.hash();
+    cellular.pinThreads();
+    DRTEST_ASSERT_EQ(cellular.hash(), hash);
+    cellular.rehash();
+    DRTEST_ASSERT_EQ(cellular.hash(), hash);
+    for (int i = 0; i < 4; ++i)
+    {
+      cellular.doUpdate();
+    }
+    DRTEST_ASSERT_EQ(cellular.space().cell(2, 1), State::live);
+    DRTEST_ASSERT_EQ(cellular.space().cell(3, 2), State::live);
+    DRTEST_ASSERT_EQ(cellular.space().cell(1, 3), State::live);
+    DRTEST_ASSERT_EQ(cellular.space().cell(2, 3), State::live);
+    DRTEST_ASSERT_EQ(cellular.space().cell(3, 3), State::live);
+
+    // At most the whole space and the buffers are resident.
+    auto bytes = cellular.memoryPerNode();
+    std::size_t total = 0;
+    for (auto node : bytes)
+    {
+      total += node;
+    }
+    std::size_t space = 64 * 48 * sizeof(State);
+    DRTEST_ASSERT_LE(total, mode == UpdateMode::buffered ? 2 * space : space + 3 * 3 * 48 * sizeof(State));
+    DRTEST_ASSERT(bytes.empty() or total > 0);
+  }
+}
@@ -0,0 +1,101 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <fstream>
+
+#include <DrMock/Test.h>
+
+#include "rules/Cyclic.h"
+#include "Cellular.h"
+#include "Checkpoint.h"
+
+using namespace drautomaton;
+
+namespace {
+
+const std::string path = "Checkpoint.test.bin";
+
+} // namespace
+
+DRTEST_TEST(roundTrip)
+{
+  using State = Cyclic<8>::State;
+  Cellular<Cyclic<8>> cellular{7, 5};
+  for (int x = 0; x < 7; ++x)
+  {
+    for (int y = 0; y < 5; ++y)
+    {
+      cellular.space().cell(x, y).value = (x * 3 + y) % 8;
+    }
+  }
+  cellular.setGeneration(1234567890123);
+
+  auto done = Checkpoint<State>::save(path, "Cyclic8", "Torus", cellular.generation(), cellular.space());
+
+  // The cells were copied, so they may be modified during the write.
+  cellular.space().fill(State{});
+  done.get();
+
+  Checkpoint<State> checkpoint{path};
+  DRTEST_ASSERT_EQ(checkpoint.rule(), std::string{"Cyclic8"});
+  DRTEST_ASSERT_EQ(checkpoint.geometry(), std::string{"Torus"});
+  DRTEST_ASSERT_EQ(checkpoint.width(), 7);
+  DRTEST_ASSERT_EQ(checkpoint.height(), 5);
+  DRTEST_ASSERT_EQ(checkpoint.generation(), 1234567890123u);
+  DRTEST_ASSERT_EQ(checkpoint.column(2)[1].value, 7);
+
+  checkpoint.restore(cellular.space());
+  for (int x = 0; x < 7; ++x)
+  {
+    for (int y = 0; y < 5; ++y)
+    {
+      DRTEST_ASSERT_EQ(cellular.space().cell(x, y).value, (x * 3 + y) % 8);
+    }
+  }
+
+  Space<State> wrong_size{5, 7};
+  DRTEST_ASSERT_THROW(checkpoint.restore(wrong_size), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+DRTEST_TEST(invalid)
+{
+  DRTEST_ASSERT_THROW(Checkpoint<int>{"does/not/exist"}, std::runtime_error);
+
+  // Wrong state size.
+  Space<std::uint8_t> space{3, 2};
+  Checkpoint<std::uint8_t>::save(path, "", "", 0, space).get();
+  DRTEST_ASSERT_THROW(Checkpoint<int>{path}, std::runtime_error);
+
+  // Truncated.
+  {
+    std::ifstream in{path, std::ios::binary};
+    std::string data{std::istreambuf_iterator<char>{in}, {}};
+    in.close();
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    out.write(data.data(), data.size() - 1);
+  }
+  DRTEST_ASSERT_THROW(Checkpoint<std::uint8_t>{path}, std::runtime_error);
+
+  DRTEST_ASSERT_THROW(
+      Checkpoint<std::uint8_t>::save(path, std::string(32, 'x'), "", 0, space),
+      std::runtime_error
+    );
+  std::remove(path.c_str());
+}
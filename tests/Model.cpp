@@ -16,17 +16,43 @@
  * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
 */
 
+#include <functional>
+
 #include <QSignalSpy>
 
 #define DRTEST_USE_QT
 #include <DrMock/Test.h>
 
 #include "mock/CellularMock.h"
+#include "geometry/Torus.h"
+#include "rules/Cyclic.h"
+#include "Cellular.h"
 #include "Model.h"
 #include "Test.h"
 
 using namespace drautomaton;
 
+namespace {
+
+// Return a model of a Cyclic CA on a torus whose cell `(x, y)` has
+// the value `fill(x, y) % 8`.
+std::shared_ptr<Model<Cyclic<8>>>
+makeCyclic(int width, int height, const std::function<int(int, int)>& fill)
+{
+  auto cellular = std::make_shared<Cellular<Cyclic<8>>>(width, height);
+  cellular->setGeometry(std::make_shared<geometry::Torus<Cyclic<8>::State>>());
+  for (int x = 0; x < width; ++x)
+  {
+    for (int y = 0; y < height; ++y)
+    {
+      cellular->space().cell(x, y).value = fill(x, y) % 8;
+    }
+  }
+  return std::make_shared<Model<Cyclic<8>>>(cellular);
+}
+
+} // namespace
+
 DRTEST_TEST(updateVertices)
 {
   // Setup first generation (for const getter).
@@ -49,6 +75,10 @@ DRTEST_TEST(updateVertices)
   space.cell(4, 2) = Test::State::dead;
   cellular->mock.space<drmock::Const>().push().returns(space).persists();
   cellular->mock.space<>().push().returns(space).persists();
+  Region changed{5, 3};
+  changed.fill();
+  cellular->mock.changed().push().returns(changed).persists();
+  cellular->mock.render().push().persists();
 
   // Create SUT. Note: During construction, `updateVertices` is called
   // for the first time. Thus, it is important to construct the
@@ -76,6 +106,236 @@ DRTEST_TEST(updateVertices)
   // sure that the output is row-major. 
   std::vector<int> expected = {0, 1, 0, 1, 0, 1};
   DRTEST_ASSERT_EQ(model->vertices(), expected);
+  DRTEST_ASSERT_EQ(model->dirty(), QRect(0, 0, 2, 3));
+}
+
+DRTEST_TEST(updatePixels)
+{
+  // Two columns of tiles, the second of which is only partially in
+  // view.
+  int width = Region::tile_size + 8;
+  int height = 3;
+  auto cellular = std::make_shared<Cellular<Test>>(width, height);
+  cellular->space().fill(Test::State::dead);
+  auto model = std::make_shared<Model<Test>>(cellular);
+  model->setViewport(4, 1, width - 6, 2);
+
+  Color dead = qRgb(0, 0, 0);
+  Color live = qRgb(255, 255, 255);
+  Palette palette{};
+  palette.setColor(0, dead);
+  palette.setColor(1, live);
+  model->setPalette(palette);
+  DRTEST_ASSERT_EQ(model->dirty(), QRect(0, 0, model->width(), model->height()));
+
+  // Change one cell in each tile behind the CA's back, then increment a
+  // cell in the second tile, so that only the second tile is reported
+  // as changed.
+  cellular->space().cell(4, 1) = Test::State::live;
+  cellular->space().cell(Region::tile_size + 2, 2) = Test::State::live;
+  cellular->increment(Region::tile_size + 5, 1);
+
+  // Only the visible part of the second tile is recolored.
+  DRTEST_ASSERT_EQ(model->pixels()[0], dead);
+  DRTEST_ASSERT_EQ(model->pixels()[model->width() + Region::tile_size - 2], live);
+  DRTEST_ASSERT_EQ(model->pixels()[Region::tile_size + 1], live);
+  DRTEST_ASSERT_EQ(model->dirty(), QRect(Region::tile_size - 4, 0, 6, 2));
+
+  // The vertices are always up-to-date.
+  DRTEST_ASSERT_EQ(model->vertices()[0], 1);
+}
+
+DRTEST_TEST(indexed)
+{
+  auto cellular = std::make_shared<Cellular<Cyclic<8>>>(40, 3);
+  for (int x = 0; x < 40; ++x)
+  {
+    for (int y = 0; y < 3; ++y)
+    {
+      cellular->space().cell(x, y).value = (x + y) % 8;
+    }
+  }
+  auto model = std::make_shared<Model<Cyclic<8>>>(cellular);
+  model->setViewport(1, 1, 38, 2);
+  DRTEST_ASSERT(model->indices().empty());
+
+  QSignalSpy updated{model.get(), &IModel::updated};
+  model->setIndexed(true);
+  DRTEST_ASSERT_EQ(updated.size(), 1);
+  DRTEST_ASSERT(model->pixels().empty());
+  DRTEST_ASSERT_EQ(model->indices().size(), 38u * 2u);
+  for (int y = 0; y < 2; ++y)
+  {
+    for (int x = 0; x < 38; ++x)
+    {
+      DRTEST_ASSERT_EQ(model->indices()[x + 38 * y], (x + y + 2) % 8);
+    }
+  }
+
+  // Changing the palette doesn't affect the indices.
+  Palette palette{};
+  palette.setColor(1, qRgb(1, 2, 3));
+  model->setPalette(palette);
+  DRTEST_ASSERT_EQ(updated.size(), 1);
+
+  model->setIndexed(false);
+  DRTEST_ASSERT(model->indices().empty());
+  DRTEST_ASSERT_EQ(model->pixels()[0], qRgb(0, 0, 0));
+  DRTEST_ASSERT_EQ(model->pixels()[1], qRgb(0, 0, 0));
+  DRTEST_ASSERT_EQ(model->pixels()[7], qRgb(1, 2, 3));
+}
+
+DRTEST_TEST(advance)
+{
+  auto fill = [] (int x, int y) { return x * y + x; };
+  auto expected = makeCyclic(40, 35, fill);
+  auto model = makeCyclic(40, 35, fill);
+
+  // The pixels are refreshed once for all generations.
+  QSignalSpy updated{model.get(), &IModel::updated};
+  for (int i = 0; i < 5; ++i)
+  {
+    expected->doUpdate();
+  }
+  model->advance(5);
+  DRTEST_ASSERT_EQ(updated.size(), 1);
+  DRTEST_ASSERT(model->pixels() == expected->pixels());
+
+  model->advance(0);
+  DRTEST_ASSERT_EQ(updated.size(), 1);
+}
+
+DRTEST_TEST(threaded)
+{
+  // Two models of the same CA, one of which runs on its own thread.
+  auto fill = [] (int x, int y) { return x * y + y; };
+  auto expected = makeCyclic(40, 35, fill);
+  auto model = makeCyclic(40, 35, fill);
+  expected->setViewport(1, 2, 38, 33);
+  model->setViewport(1, 2, 38, 33);
+  model->setThreaded(true);
+  DRTEST_ASSERT(model->threaded());
+
+  // Changing the palette is synchronous.
+  Palette palette{};
+  for (int i = 0; i < 8; ++i)
+  {
+    palette.setColor(i, qRgb(i, 0, 0));
+  }
+  expected->setPalette(palette);
+  model->setPalette(palette);
+  DRTEST_ASSERT(model->pixels() == expected->pixels());
+  expected->setStatisticsEnabled(true);
+  model->setStatisticsEnabled(true);
+
+  // Every requested generation is published and announced through
+  // `updated`.
+  QSignalSpy updated{model.get(), &IModel::updated};
+  for (int i = 0; i < 3; ++i)
+  {
+    expected->doUpdate();
+    model->doUpdate();
+    DRTEST_ASSERT(updated.wait(1000));
+    DRTEST_ASSERT(model->pixels() == expected->pixels());
+    DRTEST_ASSERT(model->statistics().histogram == expected->statistics().histogram);
+    DRTEST_ASSERT_EQ(model->statistics().changed, expected->statistics().changed);
+  }
+
+  expected->increment(3, 4);
+  model->increment(3, 4);
+  DRTEST_ASSERT(updated.wait(1000));
+  DRTEST_ASSERT(model->pixels() == expected->pixels());
+  DRTEST_ASSERT(model->vertices() == expected->vertices());
+
+  // A batch of edits is applied at once.
+  std::vector<QPoint> cells{{0, 0}, {1, 1}, {2, 2}, {1, 1}};
+  expected->incrementCells(cells);
+  model->incrementCells(cells);
+  DRTEST_ASSERT(updated.wait(1000));
+  DRTEST_ASSERT(model->pixels() == expected->pixels());
+  DRTEST_ASSERT_THROW(model->incrementCells({{38, 0}}), std::runtime_error);
+
+  model->setThreaded(false);
+  DRTEST_ASSERT(not model->threaded());
+  expected->doUpdate();
+  model->doUpdate();
+  DRTEST_ASSERT(model->pixels() == expected->pixels());
+}
+
+DRTEST_TEST(levelOfDetail)
+{
+  auto cellular = std::make_shared<Cellular<Test>>(2 * Region::tile_size, 5);
+  cellular->space().fill(Test::State::dead);
+  auto model = std::make_shared<Model<Test>>(cellular);
+  model->setViewport(1, 0, 2 * Region::tile_size - 1, 5);
+  Palette palette{};
+  palette.setColor(0, qRgb(0, 0, 0));
+  palette.setColor(1, qRgb(255, 255, 255));
+  model->setPalette(palette);
+
+  QSignalSpy viewport_changed{model.get(), &IModel::viewportChanged};
+  model->setLevelOfDetail(4, Reduction::maximum);
+  DRTEST_ASSERT_EQ(viewport_changed.size(), 1);
+  DRTEST_ASSERT_EQ(model->width(), Region::tile_size / 2);
+  DRTEST_ASSERT_EQ(model->height(), 2);
+  DRTEST_ASSERT_EQ(model->pixels().size(), static_cast<std::size_t>(Region::tile_size));
+
+  // Block coordinates are converted to the top-left cell of the block,
+  // and only the blocks of the changed tile are refreshed.
+  model->increment(Region::tile_size / 4 + 1, 1);
+  DRTEST_ASSERT_EQ(cellular->space().cell(Region::tile_size + 5, 4), Test::State::live);
+  DRTEST_ASSERT_EQ(model->dirty(), QRect(Region::tile_size / 4 - 1, 0, Region::tile_size / 4 + 1, 2));
+  DRTEST_ASSERT_EQ(model->pixels()[model->width() + Region::tile_size / 4 + 1], qRgb(255, 255, 255));
+  DRTEST_ASSERT_EQ(model->pixels()[model->width() + Region::tile_size / 4], qRgb(0, 0, 0));
+  DRTEST_ASSERT_EQ(model->vertices()[model->width() + Region::tile_size / 4 + 1], 1);
+
+  DRTEST_ASSERT_THROW(model->setLevelOfDetail(0), std::runtime_error);
+}
+
+DRTEST_TEST(pan)
+{
+  auto fill = [] (int x, int y) { return x * y + 2 * y + x; };
+  auto expected = makeCyclic(100, 90, fill);
+  auto model = makeCyclic(100, 90, fill);
+  model->setViewport(10, 10, 40, 30);
+
+  // Compare the wrap-addressed pixels of `model` with `expected`.
+  auto check = [&] ()
+    {
+      auto origin = model->origin();
+      for (int y = 0; y < 30; ++y)
+      {
+        for (int x = 0; x < 40; ++x)
+        {
+          auto i = ((y + origin.y()) % 30) * 40 + (x + origin.x()) % 40;
+          DRTEST_ASSERT_EQ(model->pixels()[i], expected->pixels()[y * 40 + x]);
+        }
+      }
+    };
+
+  // Every axis is panned separately, and only the exposed pixels are
+  // reported.
+  QSignalSpy updated{model.get(), &IModel::updated};
+  QSignalSpy viewport_changed{model.get(), &IModel::viewportChanged};
+  model->setViewport(13, 8, 40, 30);
+  expected->setViewport(13, 8, 40, 30);
+  DRTEST_ASSERT_EQ(updated.size(), 2);
+  DRTEST_ASSERT_EQ(viewport_changed.size(), 0);
+  DRTEST_ASSERT_EQ(model->origin(), QPoint(3, 28));
+  DRTEST_ASSERT_EQ(model->dirty(), QRect(0, 0, 40, 2));
+  check();
+
+  // Subsequent generations are rendered with respect to the origin.
+  model->doUpdate();
+  expected->doUpdate();
+  check();
+
+  // If the viewports don't overlap, everything is rendered anew.
+  model->setViewport(60, 50, 40, 30);
+  expected->setViewport(60, 50, 40, 30);
+  DRTEST_ASSERT_EQ(viewport_changed.size(), 1);
+  DRTEST_ASSERT_EQ(model->origin(), QPoint(0, 0));
+  check();
 }
 
 DRTEST_DATA(viewportFailure)
@@ -104,6 +364,7 @@ DRTEST_TEST(viewportFailure)
   Space<Test::State> space{4, 3};
   cellular->mock.space<drmock::Const>().push().returns(space).persists();
   cellular->mock.space<>().push().returns(space).persists();
+  cellular->mock.render().push().persists();
   auto model = std::make_shared<Model<Test>>(cellular);
 
   DRTEST_ASSERT_THROW(model->setViewport(x, y, width, height), std::runtime_error);
@@ -117,6 +378,7 @@ DRTEST_TEST(doUpdate)
   Space<Test::State> space{1, 1};
   space.cell(0, 0) = Test::State::dead;
   cellular->mock.space().push().returns(space).persists();
+  cellular->mock.render().push().persists();
 
   // Expect cellular->doUpdate to be called exactly once.
   cellular->mock.doUpdate().push().expects().times(1);
@@ -142,6 +404,7 @@ DRTEST_TEST(increment)
   // Configure cellular.
   auto cellular = std::make_shared<CellularMock<Test::State>>();
   cellular->mock.space().push().returns(space).persists();
+  cellular->mock.render().push().persists();
   cellular->mock.increment().push().expects(2, 4).times(1);
 
   // Configure model.
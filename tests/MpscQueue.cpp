@@ -0,0 +1,89 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <thread>
+#include <vector>
+
+#include <DrMock/Test.h>
+
+#include "detail/MpscQueue.h"
+
+using namespace drautomaton;
+
+DRTEST_TEST(fifo)
+{
+  MpscQueue<int> queue{};
+  int value = 0;
+  DRTEST_ASSERT(queue.empty());
+  DRTEST_ASSERT(not queue.pop(value));
+
+  queue.push(1);
+  queue.push(2);
+  DRTEST_ASSERT(not queue.empty());
+  DRTEST_ASSERT(queue.pop(value));
+  DRTEST_ASSERT_EQ(value, 1);
+  queue.push(3);
+  DRTEST_ASSERT(queue.pop(value));
+  DRTEST_ASSERT_EQ(value, 2);
+  DRTEST_ASSERT(queue.pop(value));
+  DRTEST_ASSERT_EQ(value, 3);
+  DRTEST_ASSERT(queue.empty());
+
+  // Values left in the queue are released by the dtor.
+  queue.push(4);
+}
+
+DRTEST_TEST(concurrent)
+{
+  // Every producer pushes an increasing sequence; the consumer must see
+  // every value exactly once, and the values of each producer in order.
+  MpscQueue<std::pair<int, int>> queue{};
+  int producers = 4;
+  int count = 50000;
+  std::vector<std::thread> threads{};
+  for (int p = 0; p < producers; ++p)
+  {
+    threads.emplace_back(
+        [&queue, count, p] ()
+        {
+          for (int i = 0; i < count; ++i)
+          {
+            queue.push({p, i});
+          }
+        }
+      );
+  }
+
+  std::vector<int> next(producers, 0);
+  int received = 0;
+  std::pair<int, int> value{};
+  while (received < producers * count)
+  {
+    if (queue.pop(value))
+    {
+      DRTEST_ASSERT_EQ(value.second, next[value.first]);
+      ++next[value.first];
+      ++received;
+    }
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+  DRTEST_ASSERT(queue.empty());
+}
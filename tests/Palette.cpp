@@ -0,0 +1,72 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <DrMock/Test.h>
+
+#include "detail/Colorize.h"
+#include "Palette.h"
+
+using namespace drautomaton;
+
+DRTEST_TEST(fallback)
+{
+  Palette palette{};
+  palette.setColor(2, qRgb(1, 2, 3));
+  DRTEST_ASSERT_EQ(palette.size(), 3u);
+  DRTEST_ASSERT_EQ(palette.color(2), qRgb(1, 2, 3));
+  DRTEST_ASSERT_EQ(palette.color(0), qRgb(0, 0, 0));
+  DRTEST_ASSERT_EQ(palette.color(3), qRgb(0, 0, 0));
+  DRTEST_ASSERT_EQ(palette.color(-1), qRgb(0, 0, 0));
+
+  // Only unassigned vertices are affected by the fallback color.
+  palette.setFallback(qRgb(4, 5, 6));
+  DRTEST_ASSERT_EQ(palette.color(2), qRgb(1, 2, 3));
+  DRTEST_ASSERT_EQ(palette.color(0), qRgb(4, 5, 6));
+  DRTEST_ASSERT_EQ(palette.color(1000), qRgb(4, 5, 6));
+  DRTEST_ASSERT_EQ(palette.color(-1000), qRgb(4, 5, 6));
+
+  palette.setColor(5, qRgb(7, 8, 9));
+  DRTEST_ASSERT_EQ(palette.color(4), qRgb(4, 5, 6));
+  DRTEST_ASSERT_EQ(palette.color(5), qRgb(7, 8, 9));
+
+  DRTEST_ASSERT_THROW(palette.setColor(-1, qRgb(0, 0, 0)), std::runtime_error);
+}
+
+DRTEST_TEST(colorize)
+{
+  Palette palette{qRgb(255, 0, 0)};
+  for (int i = 0; i < 26; ++i)
+  {
+    palette.setColor(i, qRgb(i, 2 * i, 3 * i));
+  }
+
+  // Odd length, so that the remainder of the vectorized loop is
+  // exercised, and out-of-range vertices.
+  std::vector<int> vertices{};
+  for (int i = 0; i < 1001; ++i)
+  {
+    vertices.push_back(i % 31 - 2);
+  }
+  std::vector<Color> pixels(vertices.size());
+  detail::colorize(vertices.data(), vertices.size(), palette, pixels.data());
+
+  for (std::size_t i = 0; i < vertices.size(); ++i)
+  {
+    DRTEST_ASSERT_EQ(pixels[i], palette.color(vertices[i]));
+  }
+}
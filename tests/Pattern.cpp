@@ -0,0 +1,179 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <sstream>
+
+#include <DrMock/Test.h>
+
+#include "Pattern.h"
+
+using namespace drautomaton;
+
+namespace {
+
+const std::vector<int> states = {0, 1, 2, 3};
+
+} // namespace
+
+DRTEST_TEST(rle)
+{
+  Space<int> space(6, 5);
+  space.fill(9);
+  std::istringstream in{
+      "#N Glider\n"
+      "#C A comment.\n"
+      "x = 3, y = 3, rule = B3/S23:T100,50\n"
+      "bob$2bo$3o!\n"
+    };
+  auto info = readRle(in, space, 1, 2, states);
+
+  DRTEST_ASSERT_EQ(info.width, 3);
+  DRTEST_ASSERT_EQ(info.height, 3);
+  DRTEST_ASSERT_EQ(info.rule, std::string{"B3/S23:T100,50"});
+
+  std::vector<std::vector<int>> expected = {
+      {9, 9, 9, 9, 9, 9},
+      {9, 9, 9, 9, 9, 9},
+      {9, 0, 1, 0, 9, 9},
+      {9, 0, 0, 1, 9, 9},
+      {9, 1, 1, 1, 9, 9}
+    };
+  for (int y = 0; y < 5; ++y)
+  {
+    for (int x = 0; x < 6; ++x)
+    {
+      DRTEST_ASSERT_EQ(space.cell(x, y), expected[y][x]);
+    }
+  }
+}
+
+DRTEST_TEST(rleMultiState)
+{
+  // Runs and rows may span several lines, cells outside of the space are
+  // skipped.
+  Space<int> space(4, 3);
+  std::istringstream in{
+      "x = 6, y = 4, rule = Cyclic\r\n"
+      "2A.B\r\n"
+      "C2$4.2C$C!\r\n"
+    };
+  readRle(in, space, -1, 0, states);
+
+  std::vector<std::vector<int>> expected = {
+      {1, 0, 2, 3},
+      {0, 0, 0, 0},
+      {0, 0, 0, 3}
+    };
+  for (int y = 0; y < 3; ++y)
+  {
+    for (int x = 0; x < 4; ++x)
+    {
+      DRTEST_ASSERT_EQ(space.cell(x, y), expected[y][x]);
+    }
+  }
+
+  std::vector<int> many(256);
+  many[255] = 7;
+  std::istringstream last{"yO!"};
+  readRle(last, space, 0, 0, many);
+  DRTEST_ASSERT_EQ(space.cell(0, 0), 7);
+}
+
+DRTEST_TEST(rleInvalid)
+{
+  Space<int> space(4, 4);
+  std::istringstream tag{"x = 1, y = 1\n2bz!"};
+  DRTEST_ASSERT_THROW(readRle(tag, space, 0, 0, states), std::runtime_error);
+  std::istringstream state{"D!"};
+  DRTEST_ASSERT_THROW(readRle(state, space, 0, 0, states), std::runtime_error);
+  std::istringstream header{"x = 1, y\nbo!"};
+  DRTEST_ASSERT_THROW(readRle(header, space, 0, 0, states), std::runtime_error);
+  std::istringstream count{"99999999999999999o!"};
+  DRTEST_ASSERT_THROW(readRle(count, space, 0, 0, states), std::runtime_error);
+}
+
+DRTEST_TEST(macrocell)
+{
+  Space<int> space(12, 12);
+  std::istringstream in{
+      "[M2] (golly 4.0)\n"
+      "#R B3/S23\n"
+      "#G 0\n"
+      ".*$..*$***$\n"
+      "4 1 0 0 1\n"
+    };
+  auto info = readMacrocell(in, space, 0, 0, states);
+  DRTEST_ASSERT_EQ(info.width, 16);
+  DRTEST_ASSERT_EQ(info.height, 16);
+  DRTEST_ASSERT_EQ(info.rule, std::string{"B3/S23"});
+
+  int count = 0;
+  for (int x = 0; x < 12; ++x)
+  {
+    for (int y = 0; y < 12; ++y)
+    {
+      count += space.cell(x, y);
+    }
+  }
+  DRTEST_ASSERT_EQ(count, 10);
+  DRTEST_ASSERT_EQ(space.cell(1, 0), 1);
+  DRTEST_ASSERT_EQ(space.cell(2, 1), 1);
+  DRTEST_ASSERT_EQ(space.cell(0, 2), 1);
+  DRTEST_ASSERT_EQ(space.cell(9, 8), 1);
+  DRTEST_ASSERT_EQ(space.cell(10, 9), 1);
+  DRTEST_ASSERT_EQ(space.cell(8, 10), 1);
+}
+
+DRTEST_TEST(macrocellMultiState)
+{
+  Space<int> space(4, 4);
+  std::istringstream in{
+      "[M2] (golly 4.0)\n"
+      "1 0 1 2 3\n"
+      "1 3 0 0 0\n"
+      "2 1 0 0 2\n"
+    };
+  readMacrocell(in, space, 0, 0, states);
+
+  std::vector<std::vector<int>> expected = {
+      {0, 1, 0, 0},
+      {2, 3, 0, 0},
+      {0, 0, 3, 0},
+      {0, 0, 0, 0}
+    };
+  for (int y = 0; y < 4; ++y)
+  {
+    for (int x = 0; x < 4; ++x)
+    {
+      DRTEST_ASSERT_EQ(space.cell(x, y), expected[y][x]);
+    }
+  }
+}
+
+DRTEST_TEST(macrocellInvalid)
+{
+  Space<int> space(4, 4);
+  std::istringstream header{"x = 1, y = 1\nbo!"};
+  DRTEST_ASSERT_THROW(readMacrocell(header, space, 0, 0, states), std::runtime_error);
+  std::istringstream forward{"[M2]\n2 1 0 0 0\n"};
+  DRTEST_ASSERT_THROW(readMacrocell(forward, space, 0, 0, states), std::runtime_error);
+  std::istringstream level{"[M2]\n1 0 0 0 1\n3 1 0 0 0\n"};
+  DRTEST_ASSERT_THROW(readMacrocell(level, space, 0, 0, states), std::runtime_error);
+  std::istringstream leaf{"[M2]\n.........*$\n"};
+  DRTEST_ASSERT_THROW(readMacrocell(leaf, space, 0, 0, states), std::runtime_error);
+}
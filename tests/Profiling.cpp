@@ -17,6 +17,8 @@
 */
 
 #include <random>
+#include <sstream>
+#include <thread>
 
 #include <QGuiApplication>
 #include <QQuickView>
@@ -31,6 +33,63 @@
 
 using namespace drautomaton;
 
+DRTEST_TEST(threads)
+{
+  // Record nested sections on multiple threads concurrently.
+  std::vector<std::thread> threads{};
+  for (int i = 0; i < 4; ++i)
+  {
+    threads.emplace_back([] () {
+        DRPROF_THREAD_NAME("Profiling worker");
+        for (int j = 0; j < 1000; ++j)
+        {
+          DRPROF_SCOPE("Profiling::outer");
+          DRPROF_SCOPE("Profiling::inner");
+        }
+      });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  DRTEST_ASSERT_EQ(drprof::getPasses("Profiling::outer"), 4000u);
+  DRTEST_ASSERT_EQ(drprof::getPasses("Profiling::inner"), 4000u);
+  DRTEST_ASSERT_LE(drprof::getTimeNs("Profiling::inner"), drprof::getTimeNs("Profiling::outer"));
+
+  // Check that the events and the lane names are exported.
+  std::stringstream trace{};
+  drprof::writeTrace(trace);
+  DRTEST_ASSERT(trace.str().find("\"name\":\"Profiling::inner\"") != std::string::npos);
+  DRTEST_ASSERT(trace.str().find("\"name\":\"Profiling worker\"") != std::string::npos);
+}
+
+DRTEST_TEST(counters)
+{
+  // Hardware counters may be unavailable (non-Linux host, VM without
+  // PMU, restrictive perf_event_paranoid); skip the test in that case.
+  if (not drprof::enableCounters(true))
+  {
+    drprof::enableCounters(false);
+    return;
+  }
+
+  volatile std::uint64_t sum = 0;
+  {
+    DRPROF_SCOPE("Profiling::counters");
+    for (std::uint64_t i = 0; i < 1000000; ++i)
+    {
+      sum = sum + i;
+    }
+  }
+  drprof::enableCounters(false);
+
+  auto counters = drprof::getCounters("Profiling::counters");
+  DRTEST_ASSERT_LT(0u, counters.values[drprof::Counters::cycles]);
+  DRTEST_ASSERT_LT(1000000u, counters.values[drprof::Counters::instructions]);
+  DRTEST_ASSERT_EQ(drprof::getThreadCounters("Profiling::counters").size(), 1u);
+}
+
 DRTEST_TEST(droppedFrames)
 {
   int argc = 0;
@@ -84,7 +143,7 @@ DRTEST_TEST(droppedFrames)
 
   // Test for dropped frames.
   int doUpdate_count = drprof::getPasses("Cellular::doUpdate");
-  int updateVertices_count = drprof::getPasses("Model::updateVertices");
-  auto diff = std::abs(doUpdate_count - updateVertices_count);
+  int updatePixels_count = drprof::getPasses("Model::updatePixels");
+  auto diff = std::abs(doUpdate_count - updatePixels_count);
   DRTEST_ASSERT_LT(diff, 2);
 }
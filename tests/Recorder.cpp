@@ -0,0 +1,147 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <DrMock/Test.h>
+
+#include "geometry/Torus.h"
+#include "rules/GameOfLife.h"
+#include "Cellular.h"
+#include "Recorder.h"
+
+using namespace drautomaton;
+
+namespace {
+
+const std::string path = "Recorder.test.bin";
+using State = GameOfLife::State;
+
+std::string
+readFile()
+{
+  std::ifstream in{path, std::ios::binary};
+  return {std::istreambuf_iterator<char>{in}, {}};
+}
+
+} // namespace
+
+DRTEST_TEST(record)
+{
+  auto cellular = std::make_shared<Cellular<GameOfLife>>(40, 36, 2);
+  cellular->setGeometry(std::make_shared<geometry::Torus<State>>());
+  cellular->increment(1, 0);
+  cellular->increment(2, 1);
+  cellular->increment(0, 2);
+  cellular->increment(1, 2);
+  cellular->increment(2, 2);
+
+  {
+    Recorder<State> recorder{cellular, path, 4, 2};
+    for (int i = 0; i < 10; ++i)
+    {
+      cellular->doUpdate();
+    }
+    DRTEST_ASSERT_EQ(recorder.frames(), 11u);
+    recorder.finish();
+  }
+
+  auto data = readFile();
+  const char* begin = data.data();
+  const char* end = begin + data.size();
+
+  detail::RecordingHeader header{};
+  std::memcpy(&header, begin, sizeof(header));
+  DRTEST_ASSERT_EQ(std::memcmp(header.magic, detail::recording_magic, 8), 0);
+  DRTEST_ASSERT_EQ(header.width, 40);
+  DRTEST_ASSERT_EQ(header.height, 36);
+  DRTEST_ASSERT_EQ(header.state_size, sizeof(State));
+  DRTEST_ASSERT_EQ(header.keyframe_interval, 4u);
+
+  detail::RecordingTrailer trailer{};
+  std::memcpy(&trailer, end - sizeof(trailer), sizeof(trailer));
+  DRTEST_ASSERT_EQ(std::memcmp(trailer.magic, detail::recording_index_magic, 8), 0);
+  DRTEST_ASSERT_EQ(trailer.frames, 11u);
+  DRTEST_ASSERT_EQ(trailer.keyframes, 3u);
+
+  // Apply all frames and compare with the final state.
+  Region layout{40, 36};
+  Space<State> space{40, 36};
+  std::vector<State> cells(Region::tile_size * Region::tile_size);
+  const char* p = begin + sizeof(header);
+  for (std::uint64_t i = 0; i < trailer.frames; ++i)
+  {
+    detail::RecordingFrame frame{};
+    std::memcpy(&frame, p, sizeof(frame));
+    p += sizeof(frame);
+    DRTEST_ASSERT_EQ(frame.keyframe != 0, i % 4 == 0);
+    if (frame.keyframe)
+    {
+      DRTEST_ASSERT_EQ(frame.tiles, 4u);
+    }
+
+    const char* frame_end = p + frame.size;
+    for (std::uint32_t j = 0; j < frame.tiles; ++j)
+    {
+      auto index = detail::readVarint(p, frame_end);
+      auto tile = layout.tile(index % layout.columns(), index / layout.columns());
+      detail::decodeRuns(p, frame_end, cells.data(), tile.width() * tile.height());
+      auto cell = cells.begin();
+      for (int x = tile.left(); x <= tile.right(); ++x)
+      {
+        for (int y = tile.top(); y <= tile.bottom(); ++y)
+        {
+          space.cell(x, y) = *cell++;
+        }
+      }
+    }
+    DRTEST_ASSERT(p == frame_end);
+  }
+  DRTEST_ASSERT(p == begin + trailer.index);
+
+  for (int x = 0; x < 40; ++x)
+  {
+    for (int y = 0; y < 36; ++y)
+    {
+      DRTEST_ASSERT(space.cell(x, y) == cellular->space().cell(x, y));
+    }
+  }
+  std::remove(path.c_str());
+}
+
+DRTEST_TEST(runs)
+{
+  std::vector<int> cells = {3, 3, 3, 0, 1, 1, 7};
+  std::vector<char> out{};
+  detail::encodeRuns(cells.data(), cells.size(), out);
+  DRTEST_ASSERT_EQ(out.size(), 4 * (1 + sizeof(int)));
+
+  std::vector<int> decoded(cells.size());
+  const char* p = out.data();
+  detail::decodeRuns(p, out.data() + out.size(), decoded.data(), decoded.size());
+  DRTEST_ASSERT(decoded == cells);
+  DRTEST_ASSERT(p == out.data() + out.size());
+
+  p = out.data();
+  DRTEST_ASSERT_THROW(
+      detail::decodeRuns(p, out.data() + out.size() - 1, decoded.data(), decoded.size()),
+      std::runtime_error
+    );
+}
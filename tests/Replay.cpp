@@ -0,0 +1,177 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#include <DrMock/Test.h>
+
+#include "geometry/Torus.h"
+#include "rules/GameOfLife.h"
+#include "Cellular.h"
+#include "Recorder.h"
+#include "Replay.h"
+
+using namespace drautomaton;
+
+namespace {
+
+const std::string path = "Replay.test.bin";
+using State = GameOfLife::State;
+
+// Record 40 generations of a glider, with a keyframe every 8 frames,
+// and return the generations.
+std::vector<std::vector<State>>
+record()
+{
+  auto cellular = std::make_shared<Cellular<GameOfLife>>(40, 36, 2);
+  cellular->setGeometry(std::make_shared<geometry::Torus<State>>());
+  cellular->increment(1, 0);
+  cellular->increment(2, 1);
+  cellular->increment(0, 2);
+  cellular->increment(1, 2);
+  cellular->increment(2, 2);
+
+  auto flatten = [&] () {
+      std::vector<State> result{};
+      for (int x = 0; x < 40; ++x)
+      {
+        const auto& column = cellular->space().data()[x];
+        result.insert(result.end(), column.begin(), column.end());
+      }
+      return result;
+    };
+
+  std::vector<std::vector<State>> generations{flatten()};
+  Recorder<State> recorder{cellular, path, 8};
+  for (int i = 0; i < 40; ++i)
+  {
+    cellular->doUpdate();
+    generations.push_back(flatten());
+  }
+  recorder.finish();
+  return generations;
+}
+
+bool
+equal(const Space<State>& space, const std::vector<State>& cells)
+{
+  for (int x = 0; x < 40; ++x)
+  {
+    for (int y = 0; y < 36; ++y)
+    {
+      if (space.cell(x, y) != cells[x * 36 + y])
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+DRTEST_TEST(seek)
+{
+  auto generations = record();
+  Replay<GameOfLife> replay{path, 2};
+  DRTEST_ASSERT_EQ(replay.frames(), 41u);
+  DRTEST_ASSERT_EQ(replay.frame(), 0u);
+  DRTEST_ASSERT(equal(replay.space(), generations[0]));
+
+  for (std::uint64_t frame : {5u, 2u, 19u, 40u, 17u, 0u, 33u, 34u})
+  {
+    replay.seek(frame);
+    DRTEST_ASSERT_EQ(replay.frame(), frame);
+    DRTEST_ASSERT(equal(replay.space(), generations[frame]));
+  }
+
+  // Seeking past the end shows the last frame.
+  replay.seek(1000);
+  DRTEST_ASSERT_EQ(replay.frame(), 40u);
+  DRTEST_ASSERT(equal(replay.space(), generations[40]));
+  std::remove(path.c_str());
+}
+
+DRTEST_TEST(play)
+{
+  auto generations = record();
+  Replay<GameOfLife> replay{path, 2};
+  replay.setStatisticsEnabled(true);
+  DRTEST_ASSERT_EQ(replay.statistics().population(), 5u);
+  for (std::uint64_t frame = 1; frame <= 40; ++frame)
+  {
+    replay.doUpdate();
+    DRTEST_ASSERT_EQ(replay.frame(), frame);
+    DRTEST_ASSERT(equal(replay.space(), generations[frame]));
+    DRTEST_ASSERT_EQ(replay.statistics().population(), 5u);
+    DRTEST_ASSERT_EQ(replay.statistics().changed, 4u);
+
+    // Every changed cell lies in a changed tile.
+    for (int x = 0; x < 40; ++x)
+    {
+      for (int y = 0; y < 36; ++y)
+      {
+        if (generations[frame][x * 36 + y] != generations[frame - 1][x * 36 + y])
+        {
+          DRTEST_ASSERT(replay.changed().isMarked(x / Region::tile_size, y / Region::tile_size));
+        }
+      }
+    }
+  }
+
+  replay.doUpdate();
+  DRTEST_ASSERT_EQ(replay.frame(), 40u);
+  DRTEST_ASSERT(replay.changed().empty());
+  std::remove(path.c_str());
+}
+
+DRTEST_TEST(unfinished)
+{
+  // Cut off the index and half of the last frame.
+  auto generations = record();
+  {
+    std::ifstream in{path, std::ios::binary};
+    std::string data{std::istreambuf_iterator<char>{in}, {}};
+    in.close();
+    detail::RecordingTrailer trailer{};
+    std::memcpy(&trailer, data.data() + data.size() - sizeof(trailer), sizeof(trailer));
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    out.write(data.data(), trailer.index - 2);
+  }
+
+  Replay<GameOfLife> replay{path, 2};
+  DRTEST_ASSERT_EQ(replay.frames(), 40u);
+  replay.seek(39);
+  DRTEST_ASSERT(equal(replay.space(), generations[39]));
+  replay.seek(9);
+  DRTEST_ASSERT(equal(replay.space(), generations[9]));
+  std::remove(path.c_str());
+}
+
+DRTEST_TEST(invalid)
+{
+  DRTEST_ASSERT_THROW(Replay<GameOfLife>{"does/not/exist"}, std::runtime_error);
+  {
+    std::ofstream out{path, std::ios::binary | std::ios::trunc};
+    out << "not a recording";
+  }
+  DRTEST_ASSERT_THROW(Replay<GameOfLife>{path}, std::runtime_error);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,77 @@
+/* Copyright 2020 Malte Kliemann, Ole Kliemann
+ *
+ * This file is part of DrAutomaton.
+ *
+ * DrAutomaton is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * DrAutomaton is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with DrAutomaton.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include <thread>
+
+#include <DrMock/Test.h>
+
+#include "detail/TripleBuffer.h"
+
+using namespace drautomaton;
+
+DRTEST_TEST(latest)
+{
+  TripleBuffer<int> buffer{};
+  DRTEST_ASSERT(not buffer.update());
+
+  // Values published while the reader is busy are skipped.
+  buffer.back() = 1;
+  buffer.publish();
+  buffer.back() = 2;
+  buffer.publish();
+  DRTEST_ASSERT(buffer.update());
+  DRTEST_ASSERT_EQ(buffer.front(), 2);
+  DRTEST_ASSERT(not buffer.update());
+  DRTEST_ASSERT_EQ(buffer.front(), 2);
+
+  buffer.back() = 3;
+  buffer.publish();
+  DRTEST_ASSERT(buffer.update());
+  DRTEST_ASSERT_EQ(buffer.front(), 3);
+}
+
+DRTEST_TEST(concurrent)
+{
+  // Each slot holds a pair of equal numbers; the reader must never see
+  // a torn pair or a value older than the previous one.
+  TripleBuffer<std::pair<int, int>> buffer{};
+  int count = 100000;
+  std::thread writer{
+      [&] ()
+      {
+        for (int i = 1; i <= count; ++i)
+        {
+          buffer.back() = {i, i};
+          buffer.publish();
+        }
+      }
+    };
+
+  int last = 0;
+  while (last < count)
+  {
+    if (buffer.update())
+    {
+      auto value = buffer.front();
+      DRTEST_ASSERT_EQ(value.first, value.second);
+      DRTEST_ASSERT_LE(last, value.first);
+      last = value.first;
+    }
+  }
+  writer.join();
+}
@@ -22,6 +22,7 @@
 
 #include <DrMock/Test.h>
 
+#include "detail/TiledNode.h"
 #include "mock/ModelMock.h"
 #include "View.h"
 #include "Cellular.h"
@@ -58,6 +59,10 @@ DRTEST_TEST(onClicked)
   model->mock.height().push()
       .returns(height)
       .persists();
+  model->mock.pixels().push()
+      .returns(std::vector<Color>{})
+      .persists();
+  model->mock.setPalette().push().persists();
   model->mock.increment().push().expects(u, v).times(1);
 
   // Configure SUT.
@@ -97,6 +102,10 @@ DRTEST_TEST(onClickedFailure)
   model->mock.height().push()
       .returns(height)
       .persists();
+  model->mock.pixels().push()
+      .returns(std::vector<Color>{})
+      .persists();
+  model->mock.setPalette().push().persists();
 
   // model->mock.increment().  // No configuration necessary.
 
@@ -110,3 +119,112 @@ DRTEST_TEST(onClickedFailure)
   cell_view.onClicked(x, y);
   DRTEST_VERIFY_MOCK(model->mock);
 }
+
+DRTEST_TEST(onDragged)
+{
+  // Configure mock component.
+  auto model = std::make_shared<ModelMock>();
+  model->mock.width().push()
+      .returns(6)
+      .persists();
+  model->mock.height().push()
+      .returns(8)
+      .persists();
+  model->mock.pixels().push()
+      .returns(std::vector<Color>{})
+      .persists();
+  model->mock.setPalette().push().persists();
+  model->mock.increment().push().expects(0, 0).times(1);
+  model->mock.incrementCells().push()
+      .expects(std::vector<QPoint>{{1, 1}, {2, 1}, {3, 2}})
+      .times(1);
+
+  // Configure SUT.
+  View cell_view{};
+  cell_view.setWidth(6);
+  cell_view.setHeight(8);
+  cell_view.setModel(model);
+
+  // Run the test. Dragging to the same cell does nothing.
+  cell_view.onClicked(0.5, 0.5);
+  cell_view.onDragged(3.5, 2.5);
+  cell_view.onDragged(3.7, 2.1);
+  DRTEST_VERIFY_MOCK(model->mock);
+}
+
+DRTEST_TEST(showNextGeneration)
+{
+  // Configure mock component.
+  auto model = std::make_shared<ModelMock>();
+  model->mock.width().push()
+      .returns(2)
+      .persists();
+  model->mock.height().push()
+      .returns(4)
+      .persists();
+  model->mock.pixels().push()
+      .returns(std::vector<Color>{})
+      .persists();
+  model->mock.setPalette().push().persists();
+  model->mock.advance().push().expects(1).times(1);
+
+  // Configure SUT.
+  View cell_view{};
+  cell_view.setModel(model);
+  cell_view.setFramerate(20);
+  DRTEST_ASSERT_EQ(cell_view.targetGenerationsPerSecond(), 20.0);
+
+  // Max speed mode doesn't affect single steps.
+  QSignalSpy max_speed{&cell_view, &View::maxSpeedChanged};
+  cell_view.setMaxSpeed(true);
+  DRTEST_ASSERT_EQ(max_speed.size(), 1);
+  DRTEST_ASSERT(cell_view.maxSpeed());
+
+  // Run the test. The model doesn't announce the generation, so the
+  // second step is not requested.
+  cell_view.showNextGeneration();
+  cell_view.showNextGeneration();
+  DRTEST_VERIFY_MOCK(model->mock);
+}
+
+// Parts of a rectangle wrapped by `TiledNode::wrap`.
+using Parts = std::array<QRect, 4>;
+
+DRTEST_DATA(wrap)
+{
+  drtest::addColumn<QRect>("rect");
+  drtest::addColumn<QPoint>("offset");
+  drtest::addColumn<Parts>("expected");  // Empty if the part doesn't exist.
+
+  drtest::addRow("no wrap", QRect{2, 1, 3, 2}, QPoint{1, 1},
+      Parts{{{3, 2, 3, 2}, {}, {}, {}}});
+  drtest::addRow("wrap x", QRect{6, 1, 4, 2}, QPoint{2, 0},
+      Parts{{{8, 1, 2, 2}, {0, 1, 2, 2}, {}, {}}});
+  drtest::addRow("wrap y", QRect{1, 4, 2, 3}, QPoint{0, 3},
+      Parts{{{1, 7, 2, 1}, {}, {1, 0, 2, 2}, {}}});
+  drtest::addRow("wrap both", QRect{7, 5, 5, 4}, QPoint{1, 1},
+      Parts{{{8, 6, 2, 2}, {0, 6, 3, 2}, {8, 0, 2, 2}, {0, 0, 3, 2}}});
+  drtest::addRow("negative offset", QRect{0, 0, 3, 3}, QPoint{-1, -2},
+      Parts{{{9, 6, 1, 2}, {0, 6, 2, 2}, {9, 0, 1, 1}, {0, 0, 2, 1}}});
+}
+
+DRTEST_TEST(wrap)
+{
+  DRTEST_FETCH(QRect, rect);
+  DRTEST_FETCH(QPoint, offset);
+  DRTEST_FETCH(Parts, expected);
+
+  // Torus of 10 x 8 pixels.
+  auto parts = TiledNode::wrap(rect, offset, {10, 8});
+  for (std::size_t i = 0; i < parts.size(); ++i)
+  {
+    if (expected[i].isEmpty())
+    {
+      DRTEST_ASSERT(parts[i].isEmpty());
+    }
+    else
+    {
+      DRTEST_ASSERT_EQ(parts[i], expected[i]);
+    }
+  }
+}
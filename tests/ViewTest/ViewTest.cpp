@@ -73,11 +73,14 @@ int main(int argc, char** argv)
   auto model = std::make_shared<drautomaton::ModelMock>();
   model->mock.width().state().returns("*", 16);
   model->mock.height().state().returns("*", 12);
+  model->mock.pixels().state().returns("*", std::vector<Color>{});
+  model->mock.dirty().state().returns("*", QRect(0, 0, 16, 12));
+  model->mock.setPalette().push().persists();
   model->mock.vertices().state().returns("", std::move(frame1))
                                 .returns("state1", std::move(frame2));
-  model->mock.doUpdate().state().emits("*", &IModel::updated);
-  model->mock.doUpdate().state().transition("", "state1")
-                                .transition("state1", "");
+  model->mock.advance().state().emits("*", 1, &IModel::updated);
+  model->mock.advance().state().transition("", "state1", 1)
+                               .transition("state1", "", 1);
 
   // auto x = model->vertices()[32];
   // assert(x == 0);